@@ -0,0 +1,332 @@
+/*
+		Copyright(C) 2025 Fordans
+						This source follows the GPL licence
+						See https://www.gnu.org/licenses/gpl-3.0.html for details
+*/
+
+/*
+	Benchmarks of FDS_EntityManager on game-like workloads. Every result is
+	one JSON object per line on stdout, so runs can be diffed or collected
+	for regression tracking; progress goes to stderr. Build optimized, e.g.
+		g++ -std=c++17 -O2 FDS_EcsBenchmark.cpp -pthread
+		cl /std:c++17 /O2 /EHsc FDS_EcsBenchmark.cpp
+	Options: --max-entities N (default 1000000), --repeat R (default 5).
+	Times are the median of the repeats.
+*/
+
+#include "../FDS_std/FDS_EntityComSystem.h"
+#include "../FDS_std/FDS_Timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+// Live heap bytes, counted by the replaced global operator new and delete below
+static std::atomic<std::size_t> g_liveBytes{ 0 };
+
+namespace
+{
+	// Each block starts with a header holding the malloc pointer and the requested size
+	void* countedAllocate(std::size_t size, std::size_t align)
+	{
+		align = std::max(align, alignof(std::max_align_t));
+		const std::size_t header = (2 * sizeof(std::size_t) + align - 1) / align * align;
+		void* raw = std::malloc(size + header + align);
+		if (!raw) throw std::bad_alloc();
+
+		std::uintptr_t user = (reinterpret_cast<std::uintptr_t>(raw) + header + align - 1) / align * align;
+		std::size_t* info = reinterpret_cast<std::size_t*>(user) - 2;
+		info[0] = reinterpret_cast<std::uintptr_t>(raw);
+		info[1] = size;
+		g_liveBytes.fetch_add(size, std::memory_order_relaxed);
+		FDS_CountAllocation();
+		return reinterpret_cast<void*>(user);
+	}
+
+	void countedFree(void* ptr) noexcept
+	{
+		if (!ptr) return;
+		std::size_t* info = static_cast<std::size_t*>(ptr) - 2;
+		g_liveBytes.fetch_sub(info[1], std::memory_order_relaxed);
+		std::free(reinterpret_cast<void*>(info[0]));
+	}
+}
+
+void* operator new(std::size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new[](std::size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t align) { return countedAllocate(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return countedAllocate(size, static_cast<std::size_t>(align)); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { countedFree(ptr); }
+
+struct Position { float x, y, z; };
+struct Velocity { float x, y, z; };
+template<> struct FDS_FloatLanes<Position> { static constexpr bool value = true; };
+template<> struct FDS_FloatLanes<Velocity> { static constexpr bool value = true; };
+struct Acceleration { float x, y, z; };
+struct Health { int value; };
+struct Team { int id; };
+struct Target { FDS_EntityID entity; };
+struct Alive {};
+struct Dead { float timer; };
+
+namespace
+{
+	std::size_t g_repeat = 5;
+	volatile float g_sink = 0.0f;
+
+	// Median seconds of g_repeat runs of func, setup runs untimed before each
+	template<typename Setup, typename Func>
+	double measure(Setup&& setup, Func&& func)
+	{
+		std::vector<double> times;
+		for (std::size_t r = 0; r < g_repeat; ++r)
+		{
+			setup();
+			FDS_Timer timer;
+			func();
+			times.push_back(timer.peek());
+		}
+		std::sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	}
+
+	template<typename Func>
+	double measure(Func&& func)
+	{
+		return measure([]() {}, std::forward<Func>(func));
+	}
+
+	void report(const char* name, const char* variant, std::size_t entities, double seconds, const std::string& extra = "")
+	{
+		std::printf("{\"benchmark\":\"%s\",\"variant\":\"%s\",\"entities\":%zu,\"seconds\":%.9f,\"ns_per_entity\":%.3f%s}\n",
+			name, variant, entities, seconds, entities ? seconds * 1e9 / static_cast<double>(entities) : 0.0, extra.c_str());
+		std::fflush(stdout);
+	}
+
+	void benchCreateDestroy(std::size_t n)
+	{
+		std::unique_ptr<FDS_EntityManager> world;
+		std::vector<FDS_EntityID> ids;
+		const auto fresh = [&]() { world = std::make_unique<FDS_EntityManager>(); ids.clear(); };
+
+		report("create", "single", n, measure(fresh, [&]()
+			{
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					const FDS_EntityID id = world->createEntity();
+					world->addComponent<Position>(id, Position{});
+					world->addComponent<Velocity>(id, Velocity{});
+				}
+			}));
+
+		report("create", "batch", n, measure(fresh, [&]()
+			{
+				ids = world->createMany(n, Position{}, Velocity{});
+			}));
+
+		std::mt19937 rng(7);
+		const auto populated = [&]()
+		{
+			fresh();
+			ids = world->createMany(n, Position{}, Velocity{});
+			std::shuffle(ids.begin(), ids.end(), rng);
+		};
+
+		report("destroy", "single", n, measure(populated, [&]()
+			{
+				for (FDS_EntityID id : ids) world->destroyEntity(id);
+			}));
+
+		report("destroy", "batch", n, measure(populated, [&]()
+			{
+				world->destroyMany(ids);
+			}));
+	}
+
+	void benchIterate(std::size_t n)
+	{
+		FDS_EntityManager world;
+		world.createMany(n, Position{ 1, 2, 3 }, Velocity{ 1, 1, 1 }, Acceleration{ 0, -9.8f, 0 });
+
+		report("iterate", "1", n, measure([&]()
+			{
+				world.each<Position>([](Position& p) { p.x += 1.0f; });
+			}));
+
+		report("iterate", "2", n, measure([&]()
+			{
+				world.each<Position, const Velocity>([](Position& p, const Velocity& v) { p.x += v.x; p.y += v.y; p.z += v.z; });
+			}));
+
+		report("iterate", "3", n, measure([&]()
+			{
+				world.each<Position, Velocity, const Acceleration>([](Position& p, Velocity& v, const Acceleration& a)
+					{
+						v.x += a.x; v.y += a.y; v.z += a.z;
+						p.x += v.x; p.y += v.y; p.z += v.z;
+					});
+			}));
+
+		report("iterate", "2_chunk", n, measure([&]()
+			{
+				world.eachChunk<Position, const Velocity>([](std::size_t count, const FDS_EntityID*, Position* p, const Velocity* v)
+					{
+						for (std::size_t i = 0; i < count; ++i) { p[i].x += v[i].x; p[i].y += v[i].y; p[i].z += v[i].z; }
+					});
+			}));
+
+		report("iterate", "2_integrate", n, measure([&]()
+			{
+				world.integrate<Position, Velocity>(0.016f);
+			}));
+	}
+
+	void benchRandomAccess(std::size_t n)
+	{
+		FDS_EntityManager world;
+		std::vector<FDS_EntityID> ids = world.createMany(n, Position{ 1, 2, 3 }, Velocity{});
+		std::shuffle(ids.begin(), ids.end(), std::mt19937(11));
+
+		report("get_component", "random_read", n, measure([&]()
+			{
+				float sum = 0.0f;
+				for (FDS_EntityID id : ids) sum += world.getComponent<const Position>(id).x;
+				g_sink = sum;
+			}));
+
+		report("get_component", "random_write", n, measure([&]()
+			{
+				for (FDS_EntityID id : ids) world.getComponent<Position>(id).y += 1.0f;
+			}));
+	}
+
+	// Random adds and removes spread the entities over many archetypes, then Position+Velocity is walked
+	void benchFragmentation(std::size_t n)
+	{
+		FDS_EntityManager world;
+		std::vector<FDS_EntityID> ids = world.createMany(n, Position{}, Velocity{});
+		const double before = measure([&]()
+			{
+				world.each<Position, const Velocity>([](Position& p, const Velocity& v) { p.x += v.x; });
+			});
+
+		std::mt19937 rng(13);
+		for (std::size_t i = 0; i < n * 2; ++i)
+		{
+			const FDS_EntityID id = ids[rng() % n];
+			switch (rng() % 8)
+			{
+			case 0: world.addComponent<Acceleration>(id, Acceleration{}); break;
+			case 1: world.removeComponent<Acceleration>(id); break;
+			case 2: world.addComponent<Health>(id, Health{ 100 }); break;
+			case 3: world.removeComponent<Health>(id); break;
+			case 4: world.addComponent<Team>(id, Team{ 1 }); break;
+			case 5: world.removeComponent<Team>(id); break;
+			case 6: world.addComponent<Target>(id, Target{ ids[rng() % n] }); break;
+			default: world.removeComponent<Target>(id); break;
+			}
+		}
+
+		std::size_t archetypes = 0;
+		for (const auto& archetype : world.getArchetypes()) archetypes += archetype->size() ? 1 : 0;
+		const double after = measure([&]()
+			{
+				world.each<Position, const Velocity>([](Position& p, const Velocity& v) { p.x += v.x; });
+			});
+
+		report("fragmentation", "before_churn", n, before);
+		report("fragmentation", "after_churn", n, after, ",\"archetypes\":" + std::to_string(archetypes));
+	}
+
+	// Every entity swaps Alive for Dead, one entity at a time or as one batch per component
+	void benchMigrate(std::size_t n)
+	{
+		std::unique_ptr<FDS_EntityManager> world;
+		std::vector<FDS_EntityID> ids;
+		const auto populated = [&]()
+		{
+			world = std::make_unique<FDS_EntityManager>();
+			ids = world->createMany(n, Position{}, Velocity{}, Health{ 100 }, Alive{});
+		};
+
+		report("migrate", "single", n, measure(populated, [&]()
+			{
+				for (FDS_EntityID id : ids)
+				{
+					world->removeComponent<Alive>(id);
+					world->addComponent<Dead>(id, Dead{ 5.0f });
+				}
+			}));
+
+		report("migrate", "batch", n, measure(populated, [&]()
+			{
+				world->removeComponents<Alive>(ids);
+				world->addComponents<Dead>(ids, Dead{ 5.0f });
+			}));
+	}
+
+	void benchMemory(std::size_t n)
+	{
+		const auto perEntity = [n](auto create)
+		{
+			const std::size_t base = g_liveBytes.load();
+			FDS_EntityManager world;
+			create(world);
+			return static_cast<double>(g_liveBytes.load() - base) / static_cast<double>(n);
+		};
+
+		const auto print = [n](const char* variant, double bytes)
+		{
+			std::printf("{\"benchmark\":\"memory\",\"variant\":\"%s\",\"entities\":%zu,\"bytes_per_entity\":%.2f}\n", variant, n, bytes);
+			std::fflush(stdout);
+		};
+
+		print("empty", perEntity([n](FDS_EntityManager& world) { world.createMany(n); }));
+		print("pos_vel_batch", perEntity([n](FDS_EntityManager& world) { world.createMany(n, Position{}, Velocity{}); }));
+		print("pos_vel_single", perEntity([n](FDS_EntityManager& world)
+			{
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					const FDS_EntityID id = world.createEntity();
+					world.addComponent<Position>(id, Position{});
+					world.addComponent<Velocity>(id, Velocity{});
+				}
+			}));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::size_t maxEntities = 1000000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (std::strcmp(argv[i], "--max-entities") == 0) maxEntities = std::strtoull(argv[i + 1], nullptr, 10);
+		else if (std::strcmp(argv[i], "--repeat") == 0) g_repeat = std::max<std::size_t>(1, std::strtoull(argv[i + 1], nullptr, 10));
+	}
+
+	for (std::size_t n = 10000; n <= maxEntities; n *= 10)
+	{
+		std::fprintf(stderr, "%zu entities\n", n);
+		benchCreateDestroy(n);
+		benchIterate(n);
+		benchRandomAccess(n);
+		benchFragmentation(n);
+		benchMigrate(n);
+		benchMemory(n);
+	}
+	return 0;
+}
\ No newline at end of file
@@ -11,29 +11,609 @@
 #include <memory>
 #include <array>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+#include <stdexcept>
+#include <utility>
+#include <functional>
+#include <tuple>
+#include <typeindex>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <cstring>
+#include <cmath>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <shared_mutex>
+#include <cassert>
+
+#include "FDS_JobSystem.h"
+#include "FDS_SignalSlotSystem.h"
+#include "FDS_Snapshot.h"
+#include "FDS_SimdKernels.h"
+#include "FDS_Profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FDS_ECS_AVX2
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#define FDS_ECS_SSE41
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FDS_ECS_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 class FDS_Component;
 class FDS_Entity;
+class FDS_EntityManager;
+
+// Number of distinct component types, define FDS_ECS_MAX_COM before including to change it
+#ifndef FDS_ECS_MAX_COM
+#define FDS_ECS_MAX_COM 256
+#endif
+
+constexpr std::size_t FDS_MAX_COM = FDS_ECS_MAX_COM;
+static_assert(FDS_MAX_COM > 0 && FDS_MAX_COM % 64 == 0, "FDS_ECS_MAX_COM must be a positive multiple of 64");
+
+// Number of distinct world resource types, define FDS_ECS_MAX_RESOURCE before including to change it
+#ifndef FDS_ECS_MAX_RESOURCE
+#define FDS_ECS_MAX_RESOURCE 64
+#endif
+
+constexpr std::size_t FDS_MAX_RESOURCE = FDS_ECS_MAX_RESOURCE;
+static_assert(FDS_MAX_RESOURCE > 0 && FDS_MAX_RESOURCE % 64 == 0, "FDS_ECS_MAX_RESOURCE must be a positive multiple of 64");
+
+inline unsigned FDS_CountTrailingZeros(std::uint64_t word) noexcept
+{
+#if defined(_MSC_VER)
+	unsigned long index;
+	_BitScanForward64(&index, word);
+	return static_cast<unsigned>(index);
+#else
+	return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+}
+
+/*
+	Component signature of Bits bits stored as 64-bit words. Subset and overlap
+	tests used by queries and the scheduler compare whole words, four at a time
+	with AVX2 or two at a time with SSE when the target has them.
+*/
+template<std::size_t Bits>
+class FDS_Signature
+{
+public:
+	static constexpr std::size_t WORDS = (Bits + 63) / 64;
+
+	bool operator[](std::size_t bit) const noexcept { return test(bit); }
+
+	bool test(std::size_t bit) const noexcept
+	{
+		return (m_words[bit / 64] >> (bit % 64)) & 1u;
+	}
+
+	FDS_Signature& set(std::size_t bit) noexcept
+	{
+		m_words[bit / 64] |= std::uint64_t(1) << (bit % 64);
+		return *this;
+	}
+
+	FDS_Signature& set(std::size_t bit, bool value) noexcept
+	{
+		return value ? set(bit) : reset(bit);
+	}
+
+	FDS_Signature& reset(std::size_t bit) noexcept
+	{
+		m_words[bit / 64] &= ~(std::uint64_t(1) << (bit % 64));
+		return *this;
+	}
+
+	void clear() noexcept
+	{
+		m_words.fill(0);
+	}
+
+	bool any() const noexcept
+	{
+		std::uint64_t bits = 0;
+		for (std::uint64_t word : m_words) bits |= word;
+		return bits != 0;
+	}
+
+	bool none() const noexcept { return !any(); }
+
+	std::size_t count() const noexcept
+	{
+		std::size_t bits = 0;
+		for (std::uint64_t word : m_words) bits += std::bitset<64>(word).count();
+		return bits;
+	}
+
+	// True if every bit of other is also set here
+	bool includes(const FDS_Signature& other) const noexcept
+	{
+		std::size_t i = 0;
+#if defined(FDS_ECS_AVX2)
+		for (; i + 4 <= WORDS; i += 4)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_words[i]));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&other.m_words[i]));
+			if (!_mm256_testc_si256(a, b)) return false;
+		}
+#endif
+#if defined(FDS_ECS_AVX2) || defined(FDS_ECS_SSE41)
+		for (; i + 2 <= WORDS; i += 2)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_words[i]));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&other.m_words[i]));
+			if (!_mm_testc_si128(a, b)) return false;
+		}
+#elif defined(FDS_ECS_SSE2)
+		for (; i + 2 <= WORDS; i += 2)
+		{
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&m_words[i]));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&other.m_words[i]));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(a, b), b)) != 0xFFFF) return false;
+		}
+#endif
+		for (; i < WORDS; ++i)
+		{
+			if ((m_words[i] & other.m_words[i]) != other.m_words[i]) return false;
+		}
+		return true;
+	}
+
+	bool intersects(const FDS_Signature& other) const noexcept
+	{
+		std::size_t i = 0;
+#if defined(FDS_ECS_AVX2)
+		for (; i + 4 <= WORDS; i += 4)
+		{
+			const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&m_words[i]));
+			const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&other.m_words[i]));
+			if (!_mm256_testz_si256(a, b)) return true;
+		}
+#endif
+		for (; i < WORDS; ++i)
+		{
+			if (m_words[i] & other.m_words[i]) return true;
+		}
+		return false;
+	}
+
+	// Calls func(bit) for every set bit, in ascending order
+	template<typename Func>
+	void forEach(Func&& func) const
+	{
+		for (std::size_t i = 0; i < WORDS; ++i)
+		{
+			for (std::uint64_t word = m_words[i]; word; word &= word - 1)
+			{
+				func(i * 64 + FDS_CountTrailingZeros(word));
+			}
+		}
+	}
+
+	FDS_Signature& operator&=(const FDS_Signature& other) noexcept
+	{
+		for (std::size_t i = 0; i < WORDS; ++i) m_words[i] &= other.m_words[i];
+		return *this;
+	}
+
+	FDS_Signature& operator|=(const FDS_Signature& other) noexcept
+	{
+		for (std::size_t i = 0; i < WORDS; ++i) m_words[i] |= other.m_words[i];
+		return *this;
+	}
+
+	friend FDS_Signature operator&(FDS_Signature a, const FDS_Signature& b) noexcept { return a &= b; }
+	friend FDS_Signature operator|(FDS_Signature a, const FDS_Signature& b) noexcept { return a |= b; }
+
+	bool operator==(const FDS_Signature& other) const noexcept { return m_words == other.m_words; }
+	bool operator!=(const FDS_Signature& other) const noexcept { return m_words != other.m_words; }
+
+	const std::array<std::uint64_t, WORDS>& words() const noexcept { return m_words; }
 
-constexpr std::size_t FDS_MAX_COM = 32;
-using FDS_ComBitSet = std::bitset<FDS_MAX_COM>;
-using FDS_ComArray = std::array<FDS_Component*, FDS_MAX_COM>;
+private:
+	std::array<std::uint64_t, WORDS> m_words = {};
+};
+
+using FDS_ComBitSet = FDS_Signature<FDS_MAX_COM>;
 
 using FDS_ComID = std::size_t;
 
-inline FDS_ComID getComTypeID()
+/*
+	Handle to an entity: a slot index into the manager's entity table plus the
+	generation of that slot. Destroying an entity bumps its slot's generation,
+	so stale handles are detected in O(1) instead of dangling. The handle is
+	trivially copyable and packs into 64 bits for components and network messages.
+*/
+struct FDS_EntityID
+{
+	std::uint32_t index = UINT32_MAX;
+	std::uint32_t generation = 0;
+
+	constexpr std::uint64_t value() const noexcept
+	{
+		return (static_cast<std::uint64_t>(generation) << 32) | index;
+	}
+
+	static constexpr FDS_EntityID fromValue(std::uint64_t value) noexcept
+	{
+		return { static_cast<std::uint32_t>(value), static_cast<std::uint32_t>(value >> 32) };
+	}
+
+	constexpr bool isNull() const noexcept { return index == UINT32_MAX; }
+
+	constexpr bool operator==(const FDS_EntityID& other) const noexcept
+	{
+		return index == other.index && generation == other.generation;
+	}
+
+	constexpr bool operator!=(const FDS_EntityID& other) const noexcept
+	{
+		return !(*this == other);
+	}
+};
+
+constexpr FDS_EntityID FDS_NULL_ENTITY = {};
+
+namespace std
+{
+	template<>
+	struct hash<FDS_EntityID>
+	{
+		std::size_t operator()(const FDS_EntityID& id) const noexcept
+		{
+			return std::hash<std::uint64_t>{}(id.value());
+		}
+	};
+
+	template<std::size_t Bits>
+	struct hash<FDS_Signature<Bits>>
+	{
+		std::size_t operator()(const FDS_Signature<Bits>& signature) const noexcept
+		{
+			std::uint64_t h = 14695981039346656037ull;
+			for (std::uint64_t word : signature.words()) h = (h ^ word) * 1099511628211ull;
+			return static_cast<std::size_t>(h);
+		}
+	};
+}
+
+// Columns are aligned to a cache line so systems never share one across chunks
+constexpr std::size_t FDS_CACHE_LINE = 64;
+
+// Matches below which parallelEach stays on the calling thread
+constexpr std::size_t FDS_DEFAULT_GRAIN = 4096;
+
+constexpr FDS_ComID FDS_INVALID_COM = SIZE_MAX;
+
+// Compiler-provided name of T, e.g. "Position" or "game::Health"
+template<typename T>
+constexpr std::string_view FDS_TypeName() noexcept
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+	constexpr std::string_view signature = __FUNCSIG__;
+	constexpr std::size_t begin = signature.find("FDS_TypeName<") + 13;
+	constexpr std::size_t end = signature.rfind(">(void)");
+	constexpr std::string_view name = signature.substr(begin, end - begin);
+	if constexpr (name.substr(0, 7) == "struct ") return name.substr(7);
+	else if constexpr (name.substr(0, 6) == "class ") return name.substr(6);
+	else if constexpr (name.substr(0, 5) == "enum ") return name.substr(5);
+	else return name;
+#else
+	constexpr std::string_view signature = __PRETTY_FUNCTION__;
+	constexpr std::size_t begin = signature.find("T = ") + 4;
+	constexpr std::size_t end = signature.find_first_of(";]", begin);
+	return signature.substr(begin, end - begin);
+#endif
+}
+
+constexpr std::uint64_t FDS_HashName(std::string_view name) noexcept
+{
+	std::uint64_t hash = 14695981039346656037ull;
+	for (char c : name) hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+	return hash;
+}
+
+enum class FDS_ComStorage
+{
+	Table,        // Column in the entity's archetype, best for iteration
+	SparseSet     // FDS_ComPool owned by the manager, best for frequent add/remove
+};
+
+// Specialize to choose where a data component is stored
+template<typename T>
+struct FDS_ComTraits
+{
+	static constexpr FDS_ComStorage storage = FDS_ComStorage::Table;
+};
+
+template<typename T>
+constexpr bool FDS_IS_TABLE_COM = FDS_ComTraits<std::remove_const_t<T>>::storage == FDS_ComStorage::Table;
+
+// Empty table types are tags: a signature bit, with no column and no ticks
+template<typename T>
+constexpr bool FDS_IS_TAG_COM = std::is_empty_v<std::remove_const_t<T>> && FDS_IS_TABLE_COM<T>;
+
+// The object every holder of the tag T is handed, tags have no per-entity storage
+template<typename T>
+T& FDS_TagInstance() noexcept
+{
+	static_assert(std::is_default_constructible_v<T>, "Tag types must be default constructible");
+	static T tag;
+	return tag;
+}
+
+/*
+	Specialize for component types that are not trivially copyable to put
+	them into snapshots:
+		static void save(const T& com, FDS_SnapshotWriter& out);
+		static void load(T& com, FDS_SnapshotReader& in);
+	load receives a default-constructed T.
+*/
+template<typename T>
+struct FDS_ComSerializer
+{
+};
+
+template<typename T, typename = void>
+constexpr bool FDS_HAS_SERIALIZER = false;
+
+template<typename T>
+constexpr bool FDS_HAS_SERIALIZER<T, std::void_t<decltype(FDS_ComSerializer<T>::save(std::declval<const T&>(), std::declval<FDS_SnapshotWriter&>()))>> = true;
+
+class FDS_ComPoolBase;
+
+template<typename T>
+class FDS_ComPool;
+
+class FDS_OwningGroup;
+
+/*
+	Type-erased description of a component type. The storage layer uses it to
+	move, copy and destroy components without knowing their type, and the hash
+	identifies the type across runs and modules built by the same compiler.
+	Operations the type does not support are nullptr.
+*/
+struct FDS_ComTypeInfo
+{
+	FDS_ComID id;
+	std::uint64_t hash;
+	std::string_view name;
+	std::size_t size;
+	std::size_t align;
+	bool trivial;                                        // trivially copyable, moved with memcpy
+	bool empty;
+	FDS_ComStorage storage;
+	void (*construct)(void* dst);
+	void (*copyConstruct)(void* dst, const void* src);
+	void (*moveConstruct)(void* dst, void* src);
+	void (*destroy)(void* ptr);
+	std::unique_ptr<FDS_ComPoolBase> (*createPool)();     // sparse-set types only
+	void (*save)(const void* src, std::size_t count, FDS_SnapshotWriter& out);
+	void (*load)(void* dst, std::size_t count, FDS_SnapshotReader& in);   // into live objects
+
+	// Moves count objects from src to dst and ends the lifetime of the sources
+	void relocate(void* dst, void* src, std::size_t count) const
+	{
+		if (trivial)
+		{
+			if (count) std::memcpy(dst, src, count * size);
+			return;
+		}
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			void* from = static_cast<std::byte*>(src) + i * size;
+			moveConstruct(static_cast<std::byte*>(dst) + i * size, from);
+			destroy(from);
+		}
+	}
+
+	template<typename T>
+	static FDS_ComTypeInfo describe() noexcept
+	{
+		FDS_ComTypeInfo info = {};
+		info.id = FDS_INVALID_COM;
+		info.name = FDS_TypeName<T>();
+		info.hash = FDS_HashName(info.name);
+		info.size = sizeof(T);
+		info.align = alignof(T);
+		info.trivial = std::is_trivially_copyable_v<T>;
+		info.empty = std::is_empty_v<T>;
+		info.storage = FDS_ComTraits<T>::storage;
+		if constexpr (std::is_default_constructible_v<T>)
+		{
+			info.construct = [](void* dst) { new (dst) T(); };
+		}
+		if constexpr (std::is_copy_constructible_v<T>)
+		{
+			info.copyConstruct = [](void* dst, const void* src) { new (dst) T(*static_cast<const T*>(src)); };
+		}
+		if constexpr (std::is_move_constructible_v<T>)
+		{
+			info.moveConstruct = [](void* dst, void* src) { new (dst) T(std::move(*static_cast<T*>(src))); };
+		}
+		if constexpr (std::is_destructible_v<T>)
+		{
+			info.destroy = [](void* ptr) { static_cast<T*>(ptr)->~T(); };
+		}
+		if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			info.createPool = []() -> std::unique_ptr<FDS_ComPoolBase> { return std::make_unique<FDS_ComPool<T>>(); };
+		}
+		if constexpr (FDS_HAS_SERIALIZER<T>)
+		{
+			info.save = [](const void* src, std::size_t count, FDS_SnapshotWriter& out)
+			{
+				for (std::size_t i = 0; i < count; ++i) FDS_ComSerializer<T>::save(static_cast<const T*>(src)[i], out);
+			};
+			info.load = [](void* dst, std::size_t count, FDS_SnapshotReader& in)
+			{
+				for (std::size_t i = 0; i < count; ++i) FDS_ComSerializer<T>::load(static_cast<T*>(dst)[i], in);
+			};
+		}
+		else if constexpr (std::is_trivially_copyable_v<T>)
+		{
+			info.save = [](const void* src, std::size_t count, FDS_SnapshotWriter& out) { out.write(src, count * sizeof(T)); };
+			info.load = [](void* dst, std::size_t count, FDS_SnapshotReader& in) { in.read(dst, count * sizeof(T)); };
+		}
+		return info;
+	}
+};
+
+/*
+	Process-wide table of component types. A type gets the id it was explicitly
+	registered with, or else the lowest free id on first use; registration is
+	locked, so first touches from several threads are safe. Ids that must not
+	depend on first-use order, e.g. to match between processes, should be fixed
+	with FDS_RegisterComponent<T>(id) at startup. Types are keyed by name hash,
+	so modules sharing one registry agree on ids. A name seen twice is taken
+	as one type only when it was pinned with FDS_RegisterComponent or is
+	trivially copyable, and only with the same size, alignment and storage;
+	otherwise, e.g. for two types in anonymous namespaces of different files,
+	it throws std::logic_error rather than mix up their functions.
+*/
+class FDS_ComRegistry
+{
+public:
+	static FDS_ComRegistry& instance()
+	{
+		static FDS_ComRegistry registry;
+		return registry;
+	}
+
+	template<typename T>
+	const FDS_ComTypeInfo& add(FDS_ComID requested = FDS_INVALID_COM)
+	{
+		return add(FDS_ComTypeInfo::describe<T>(), requested);
+	}
+
+	const FDS_ComTypeInfo& add(FDS_ComTypeInfo info, FDS_ComID requested = FDS_INVALID_COM)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		auto it = m_byHash.find(info.hash);
+		if (it != m_byHash.end())
+		{
+			const FDS_ComTypeInfo& known = *it->second;
+			if (requested != FDS_INVALID_COM && requested != known.id)
+			{
+				throw std::logic_error("FDS_ComRegistry: " + std::string(info.name) + " is already registered with another id");
+			}
+			if (info.size != known.size || info.align != known.align || info.trivial != known.trivial || info.empty != known.empty || info.storage != known.storage)
+			{
+				throw std::logic_error("FDS_ComRegistry: " + std::string(info.name) + " is registered with another layout, two types share its name");
+			}
+			if (requested != FDS_INVALID_COM) m_pinned.set(known.id);
+			else if (!known.trivial && !m_pinned.test(known.id))
+			{
+				throw std::logic_error("FDS_ComRegistry: " + std::string(info.name) + " is registered twice, pin it with FDS_RegisterComponent to share it");
+			}
+			return known;
+		}
+
+		const bool explicitID = requested != FDS_INVALID_COM;
+		if (!explicitID)
+		{
+			while (m_next < FDS_MAX_COM && m_infos[m_next]) ++m_next;
+			requested = m_next;
+		}
+		if (requested >= FDS_MAX_COM) throw std::length_error("FDS_ECS_MAX_COM component types exceeded");
+		if (m_infos[requested]) throw std::logic_error("FDS_ComRegistry: id of " + std::string(info.name) + " is taken by " + std::string(m_infos[requested]->name));
+
+		if (explicitID) m_pinned.set(requested);
+		info.id = requested;
+		m_storage.push_back(info);
+		m_infos[requested] = &m_storage.back();
+		m_byHash.emplace(info.hash, &m_storage.back());
+		return m_storage.back();
+	}
+
+	const FDS_ComTypeInfo* find(FDS_ComID id) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return id < FDS_MAX_COM ? m_infos[id] : nullptr;
+	}
+
+	const FDS_ComTypeInfo* findByHash(std::uint64_t hash) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_byHash.find(hash);
+		return it != m_byHash.end() ? it->second : nullptr;
+	}
+
+private:
+	FDS_ComRegistry() = default;
+
+	mutable std::mutex m_mutex;
+	std::deque<FDS_ComTypeInfo> m_storage;
+	std::array<const FDS_ComTypeInfo*, FDS_MAX_COM> m_infos = {};
+	std::unordered_map<std::uint64_t, const FDS_ComTypeInfo*> m_byHash;
+	std::bitset<FDS_MAX_COM> m_pinned;                   // ids given by FDS_RegisterComponent
+	FDS_ComID m_next = 0;
+};
+
+template<typename T>
+inline const FDS_ComTypeInfo& getComTypeInfo()
 {
-	static FDS_ComID lastID = 0;
-	return lastID++;
+	static const FDS_ComTypeInfo& info = FDS_ComRegistry::instance().add<T>();
+	return info;
 }
 
+// After the first call this is a plain load of a function-local static. The first
+// call registers T and throws std::length_error past FDS_ECS_MAX_COM types.
 template<typename T>
-inline FDS_ComID getComTypeID() noexcept
+inline FDS_ComID getComTypeID()
 {
-	static FDS_ComID typeID = getComTypeID();
+	static const FDS_ComID typeID = getComTypeInfo<T>().id;
 	return typeID;
 }
 
+// Fixes T's id, must run before T is first used
+template<typename T>
+inline FDS_ComID FDS_RegisterComponent(FDS_ComID id)
+{
+	return FDS_ComRegistry::instance().add<T>(id).id;
+}
+
+using FDS_ResourceID = std::size_t;
+using FDS_ResourceBitSet = FDS_Signature<FDS_MAX_RESOURCE>;
+
+/*
+	Next dense resource id, taken once per type by getResourceID. Resources
+	are never saved, so unlike component ids they need no name: two types
+	that share one, such as structs in anonymous namespaces, stay apart.
+*/
+inline FDS_ResourceID FDS_NextResourceID()
+{
+	static std::mutex mutex;
+	static FDS_ResourceID next = 0;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if (next >= FDS_MAX_RESOURCE) throw std::length_error("FDS_ECS_MAX_RESOURCE resource types exceeded");
+	return next++;
+}
+
+template<typename T>
+inline FDS_ResourceID getResourceID()
+{
+	static const FDS_ResourceID id = FDS_NextResourceID();
+	return id;
+}
+
 class FDS_Component
 {
 public:
@@ -45,98 +625,4348 @@ public:
 	virtual void draw() {}
 };
 
-class FDS_Entity
+// Ticks of the world in which a component was added and last written
+struct FDS_ComTicks
+{
+	std::uint32_t added = 0;
+	std::uint32_t changed = 0;
+};
+
+// Calls func(i, run) for each run of consecutive values rows[i] .. rows[i] + run - 1 of ascending rows
+template<typename Func>
+void FDS_ForEachRun(const std::uint32_t* rows, std::size_t count, Func&& func)
+{
+	for (std::size_t i = 0, run; i < count; i += run)
+	{
+		for (run = 1; i + run < count && rows[i + run] == rows[i] + run; ++run) {}
+		func(i, run);
+	}
+}
+
+/*
+	Ticks of every element of a column or pool plus, for each chunk of CHUNK
+	elements, the newest ticks in it, so change filters skip whole chunks that
+	nothing touched. Chunks are cache-line sized in rows like parallelEach's
+	splits; chunk ticks are atomic because pool elements of one chunk may be
+	written from several jobs.
+*/
+class FDS_TickArray
 {
 public:
-	void update()
+	static constexpr std::size_t CHUNK = FDS_CACHE_LINE;
+
+	// Source of the tick stamped on appended elements
+	void setClock(const std::uint32_t* clock) noexcept { m_clock = clock; }
+	std::uint32_t now() const noexcept { return m_clock ? *m_clock : 0; }
+
+	std::size_t size() const noexcept { return m_ticks.size(); }
+	const FDS_ComTicks& operator[](std::size_t i) const noexcept { return m_ticks[i]; }
+
+	// Newest ticks among the elements of chunk c
+	FDS_ComTicks chunk(std::size_t c) const noexcept
 	{
-		for (auto& c : m_components) c->update();
+		return { m_chunks[c].added.load(std::memory_order_relaxed), m_chunks[c].changed.load(std::memory_order_relaxed) };
 	}
 
-	void draw() 
+	void reserve(std::size_t capacity)
 	{
-		for (auto& c : m_components) c->draw();
+		m_ticks.reserve(capacity);
+		m_chunks.reserve((capacity + CHUNK - 1) / CHUNK);
 	}
 
-	bool isActive() const noexcept
+	// Appends count elements added now
+	void append(std::size_t count)
 	{
-		return m_isActive;
+		const std::uint32_t tick = now();
+		append({ tick, tick }, count);
 	}
 
-	void destroy() noexcept
+	void append(FDS_ComTicks ticks, std::size_t count)
 	{
-		m_isActive = false;
+		const std::size_t first = m_ticks.size();
+		m_ticks.insert(m_ticks.end(), count, ticks);
+		m_chunks.resize((m_ticks.size() + CHUNK - 1) / CHUNK);
+		for (std::size_t c = first / CHUNK; c < m_chunks.size(); ++c) raise(c, ticks);
 	}
 
-	template<typename T>
-	bool hasComponent() const noexcept
+	// Appends the ticks of count elements of src, rows ascending
+	void appendRows(const FDS_TickArray& src, const std::uint32_t* rows, std::size_t count)
 	{
-		return m_comBitSet[getComTypeID<T>()];
+		const std::size_t first = m_ticks.size();
+		m_ticks.resize(first + count);
+		FDS_ForEachRun(rows, count, [&](std::size_t i, std::size_t run)
+			{
+				std::memcpy(&m_ticks[first + i], &src.m_ticks[rows[i]], run * sizeof(FDS_ComTicks));
+			});
+		m_chunks.resize((m_ticks.size() + CHUNK - 1) / CHUNK);
+		for (std::size_t i = first; i < m_ticks.size(); ++i) raise(i / CHUNK, m_ticks[i]);
 	}
 
-	template<typename T,typename... TArgs>
-	T& addComponent(TArgs&&... mArgs)
+	// Appends count ticks stored as raw bytes, e.g. in a snapshot
+	void appendBytes(const std::byte* src, std::size_t count)
 	{
-		T* com( new T( std::forward<TArgs>(mArgs)... ) );
-		com->owner = this;
+		const std::size_t first = m_ticks.size();
+		m_ticks.resize(first + count);
+		if (count) std::memcpy(&m_ticks[first], src, count * sizeof(FDS_ComTicks));
+		m_chunks.resize((m_ticks.size() + CHUNK - 1) / CHUNK);
+		for (std::size_t i = first; i < m_ticks.size(); ++i) raise(i / CHUNK, m_ticks[i]);
+	}
 
-		std::unique_ptr<FDS_Component> uPtr{ com };
-		m_components.emplace_back(std::move(uPtr));
+	const FDS_ComTicks* data() const noexcept { return m_ticks.data(); }
 
-		m_comArray[getComTypeID<T>()] = com;
-		m_comBitSet[getComTypeID<T>()] = true;
+	// Element i was written at tick
+	void touch(std::size_t i, std::uint32_t tick) noexcept
+	{
+		m_ticks[i].changed = tick;
+		m_chunks[i / CHUNK].changed.store(tick, std::memory_order_relaxed);
+	}
 
-		com->init();
-		return *com;
+	void touch(std::size_t begin, std::size_t end, std::uint32_t tick) noexcept
+	{
+		for (std::size_t i = begin; i < end; ++i) m_ticks[i].changed = tick;
+		for (std::size_t c = begin / CHUNK; c * CHUNK < end; ++c) m_chunks[c].changed.store(tick, std::memory_order_relaxed);
 	}
 
-	template<typename T>
-	T& getComponent() const noexcept
+	void swap(std::size_t i, std::size_t j) noexcept
+	{
+		std::swap(m_ticks[i], m_ticks[j]);
+		raise(i / CHUNK, m_ticks[i]);
+		raise(j / CHUNK, m_ticks[j]);
+	}
+
+	// Moves the last element into i
+	void swapRemove(std::size_t i) noexcept
+	{
+		const FDS_ComTicks moved = m_ticks.back();
+		m_ticks.pop_back();
+		if (i < m_ticks.size())
+		{
+			m_ticks[i] = moved;
+			raise(i / CHUNK, moved);
+		}
+		if (m_chunks.size() * CHUNK >= m_ticks.size() + CHUNK) m_chunks.pop_back();
+	}
+
+	void truncate(std::size_t size) noexcept
 	{
-		auto ptr( m_comArray[getComTypeID<T>()] );
-		return *static_cast<T*>(ptr);
+		if (size >= m_ticks.size()) return;
+		m_ticks.resize(size);
+		while (m_chunks.size() * CHUNK >= size + CHUNK) m_chunks.pop_back();
 	}
 
 private:
-	bool m_isActive = true;
-	std::vector<std::unique_ptr<FDS_Component>> m_components = {};
-	FDS_ComArray m_comArray = {};
-	FDS_ComBitSet m_comBitSet = {};
+	// Copyable so the vector can grow, which only happens during structural changes
+	struct Chunk
+	{
+		std::atomic<std::uint32_t> added{ 0 };
+		std::atomic<std::uint32_t> changed{ 0 };
+
+		Chunk() = default;
+		Chunk(const Chunk& other) noexcept
+			: added(other.added.load(std::memory_order_relaxed)), changed(other.changed.load(std::memory_order_relaxed))
+		{
+		}
+	};
+
+	void raise(std::size_t c, FDS_ComTicks ticks) noexcept
+	{
+		Chunk& chunk = m_chunks[c];
+		if (ticks.added > chunk.added.load(std::memory_order_relaxed)) chunk.added.store(ticks.added, std::memory_order_relaxed);
+		if (ticks.changed > chunk.changed.load(std::memory_order_relaxed)) chunk.changed.store(ticks.changed, std::memory_order_relaxed);
+	}
+
+	std::vector<FDS_ComTicks> m_ticks;
+	std::vector<Chunk> m_chunks;
+	const std::uint32_t* m_clock = nullptr;
 };
 
-class FDS_EntityManager
+/*
+	Contiguous, type-erased array holding one component type of an archetype.
+	Row i of every column in an archetype belongs to the same entity.
+*/
+class FDS_Column
 {
 public:
-	void update()
+	explicit FDS_Column(const FDS_ComTypeInfo& info, const std::uint32_t* clock = nullptr) noexcept : m_info(&info)
 	{
-		for (auto& e : m_entities) e->update();
+		m_ticks.setClock(clock);
 	}
 
-	void draw()
+	FDS_Column(FDS_Column&& other) noexcept
+		: m_info(other.m_info), m_data(other.m_data), m_size(other.m_size), m_capacity(other.m_capacity), m_ticks(std::move(other.m_ticks))
 	{
-		for (auto& e : m_entities) e->draw();
+		other.m_data = nullptr;
+		other.m_size = 0;
+		other.m_capacity = 0;
 	}
 
-	void refresh()
+	FDS_Column(const FDS_Column&) = delete;
+	FDS_Column& operator=(const FDS_Column&) = delete;
+	FDS_Column& operator=(FDS_Column&&) = delete;
+
+	~FDS_Column()
 	{
-		m_entities.erase(
-			std::remove_if
-			(
-				std::begin(m_entities),
-				std::end(m_entities),
-				[](const std::unique_ptr<FDS_Entity>& mEntity) {return !mEntity->isActive();}
-			),
-			std::end(m_entities)
-		);
+		clear();
+		deallocate(m_data);
 	}
 
-	FDS_Entity& addEntity()
+	const FDS_ComTypeInfo& info() const noexcept { return *m_info; }
+	std::size_t size() const noexcept { return m_size; }
+
+	void* get(std::size_t row) noexcept { return m_data + row * m_info->size; }
+	const void* get(std::size_t row) const noexcept { return m_data + row * m_info->size; }
+
+	template<typename T>
+	T* data() noexcept { return std::launder(reinterpret_cast<T*>(m_data)); }
+
+	// Added and changed ticks of each row
+	FDS_TickArray& ticks() noexcept { return m_ticks; }
+	const FDS_TickArray& ticks() const noexcept { return m_ticks; }
+
+	void reserve(std::size_t capacity)
 	{
-		FDS_Entity* e = new FDS_Entity();
-		std::unique_ptr<FDS_Entity> uPtr{ e };
-		m_entities.emplace_back(std::move(uPtr));
-		return *e;
+		if (capacity <= m_capacity) return;
+
+		m_ticks.reserve(capacity);
+
+		std::byte* data = allocate(capacity);
+		m_info->relocate(data, m_data, m_size);
+		deallocate(m_data);
+		m_data = data;
+		m_capacity = capacity;
+	}
+
+	template<typename T, typename... TArgs>
+	T& emplace(TArgs&&... mArgs)
+	{
+		grow(1);
+		T* com = new (get(m_size)) T(std::forward<TArgs>(mArgs)...);
+		++m_size;
+		m_ticks.append(1);
+		return *com;
+	}
+
+	// Move-constructs src's row at the end of this column, src's row is left moved-from
+	void pushFrom(FDS_Column& src, std::size_t row)
+	{
+		grow(1);
+		if (m_info->trivial) std::memcpy(get(m_size), src.get(row), m_info->size);
+		else m_info->moveConstruct(get(m_size), src.get(row));
+		++m_size;
+		m_ticks.append(src.m_ticks[row], 1);
+	}
+
+	// pushFrom() for count rows of src, rows ascending; adjacent rows of trivial types are copied as one block
+	void pushRows(FDS_Column& src, const std::uint32_t* rows, std::size_t count)
+	{
+		grow(count);
+		if (m_info->trivial)
+		{
+			FDS_ForEachRun(rows, count, [&](std::size_t i, std::size_t run)
+				{
+					std::memcpy(get(m_size), src.get(rows[i]), run * m_info->size);
+					m_size += run;
+				});
+		}
+		else
+		{
+			for (std::size_t i = 0; i < count; ++i, ++m_size) m_info->moveConstruct(get(m_size), src.get(rows[i]));
+		}
+		m_ticks.appendRows(src.m_ticks, rows, count);
 	}
+
+	// Appends count default-constructed elements
+	void emplaceDefault(std::size_t count)
+	{
+		grow(count);
+		for (std::size_t i = 0; i < count; ++i, ++m_size) m_info->construct(get(m_size));
+		m_ticks.append(count);
+	}
+
+	// Appends count copies of prototype
+	void emplaceCopies(const void* prototype, std::size_t count)
+	{
+		grow(count);
+		if (m_info->trivial)
+		{
+			for (std::size_t i = 0; i < count; ++i, ++m_size) std::memcpy(get(m_size), prototype, m_info->size);
+		}
+		else
+		{
+			for (std::size_t i = 0; i < count; ++i, ++m_size) m_info->copyConstruct(get(m_size), prototype);
+		}
+		m_ticks.append(count);
+	}
+
+	// Writes the ticks, then the elements, as a snapshot block
+	void save(FDS_SnapshotWriter& out) const
+	{
+		if (!m_info->save) throw std::runtime_error("FDS_Column: " + std::string(m_info->name) + " needs an FDS_ComSerializer specialization");
+		out.write(m_ticks.data(), m_size * sizeof(FDS_ComTicks));
+		m_info->save(m_data, m_size, out);
+	}
+
+	// Appends count elements of a block written by save()
+	void load(FDS_SnapshotReader& in, std::size_t count)
+	{
+		if (!m_info->load || (!m_info->trivial && !m_info->construct))
+		{
+			throw std::runtime_error("FDS_Column: " + std::string(m_info->name) + " cannot be loaded from a snapshot");
+		}
+
+		const std::byte* ticks = in.take(count * sizeof(FDS_ComTicks));
+		const std::size_t first = m_size;
+		grow(count);
+		if (m_info->trivial)
+		{
+			in.read(get(first), count * m_info->size);
+			m_size += count;
+		}
+		else
+		{
+			emplaceDefault(count);
+			try
+			{
+				m_info->load(get(first), count, in);
+			}
+			catch (...)
+			{
+				truncate(first);
+				throw;
+			}
+			m_ticks.truncate(first);
+		}
+		m_ticks.appendBytes(ticks, count);
+	}
+
+	// Destroys the elements from size on
+	void truncate(std::size_t size) noexcept
+	{
+		if (!m_info->trivial)
+		{
+			for (std::size_t i = size; i < m_size; ++i) m_info->destroy(get(i));
+		}
+		m_size = std::min(size, m_size);
+		m_ticks.truncate(size);
+	}
+
+	// Destroys the row and fills the hole with the last element
+	void swapRemove(std::size_t row) noexcept
+	{
+		const std::size_t last = m_size - 1;
+		if (!m_info->trivial) m_info->destroy(get(row));
+		if (row != last) m_info->relocate(get(row), get(last), 1);
+		--m_size;
+		m_ticks.swapRemove(row);
+	}
+
+	void clear() noexcept
+	{
+		truncate(0);
+	}
+
+private:
+	void grow(std::size_t count)
+	{
+		if (m_size + count > m_capacity) reserve(std::max(m_size + count, m_capacity ? m_capacity * 2 : 16));
+	}
+
+	std::size_t alignment() const noexcept
+	{
+		return std::max(m_info->align, FDS_CACHE_LINE);
+	}
+
+	std::byte* allocate(std::size_t capacity) const
+	{
+		return static_cast<std::byte*>(::operator new(capacity * m_info->size, std::align_val_t{ alignment() }));
+	}
+
+	void deallocate(std::byte* data) const noexcept
+	{
+		if (data) ::operator delete(data, std::align_val_t{ alignment() });
+	}
+
+private:
+	const FDS_ComTypeInfo* m_info;
+	std::byte* m_data = nullptr;
+	std::size_t m_size = 0;
+	std::size_t m_capacity = 0;
+	FDS_TickArray m_ticks;
+};
+
+/*
+	All entities sharing the same component signature live in one archetype,
+	one column per component type, so systems walk dense memory.
+*/
+class FDS_Archetype
+{
+public:
+	// Columns stamp new rows with the tick clock points to
+	FDS_Archetype(const FDS_ComBitSet& signature, const std::vector<const FDS_ComTypeInfo*>& infos, const std::uint32_t* clock = nullptr)
+		: m_signature(signature)
+	{
+		m_columnIndex.fill(-1);
+		m_columns.reserve(infos.size());
+		for (const FDS_ComTypeInfo* info : infos)
+		{
+			if (info->empty) continue;
+			m_columnIndex[info->id] = static_cast<std::int16_t>(m_columns.size());
+			m_columns.emplace_back(*info, clock);
+		}
+	}
+
+	const FDS_ComBitSet& signature() const noexcept { return m_signature; }
+	std::size_t size() const noexcept { return m_entities.size(); }
+	const std::vector<FDS_EntityID>& entities() const noexcept { return m_entities; }
+
+	template<typename T>
+	bool hasComponent() const
+	{
+		return m_signature[getComTypeID<T>()];
+	}
+
+	// Returns the first element of T's column, or nullptr if the archetype has no T or T is a tag
+	template<typename T>
+	T* column()
+	{
+		FDS_Column* col = findColumn(getComTypeID<T>());
+		return col ? col->data<T>() : nullptr;
+	}
+
+	FDS_Column* findColumn(FDS_ComID id) noexcept
+	{
+		const std::int16_t index = m_columnIndex[id];
+		return index < 0 ? nullptr : &m_columns[index];
+	}
+
+private:
+	friend class FDS_EntityManager;
+
+	FDS_ComBitSet m_signature;
+	std::vector<FDS_EntityID> m_entities;
+	std::vector<FDS_Column> m_columns;
+	std::array<std::int16_t, FDS_MAX_COM> m_columnIndex;
+	std::unordered_map<FDS_ComID, FDS_Archetype*> m_addEdges;
+	std::unordered_map<FDS_ComID, FDS_Archetype*> m_removeEdges;
+};
+
+/*
+	Sparse-set storage: a packed array of components and their entities plus
+	a paged sparse index from entity to packed slot. Add, remove and lookup
+	are O(1), and iterating the packed arrays only visits entities that have
+	the component. Adding or removing never moves the entity's other components.
+*/
+class FDS_ComPoolBase
+{
+public:
+	static constexpr std::size_t PAGE_SIZE = 4096;
+	static constexpr std::uint32_t NULL_SLOT = UINT32_MAX;
+
+	virtual ~FDS_ComPoolBase() = default;
+
+	bool contains(FDS_EntityID id) const noexcept
+	{
+		const std::uint32_t slot = find(id);
+		return slot != NULL_SLOT && m_entities[slot] == id;
+	}
+
+	std::size_t size() const noexcept { return m_entities.size(); }
+	bool empty() const noexcept { return m_entities.empty(); }
+	const std::vector<FDS_EntityID>& entities() const noexcept { return m_entities; }
+
+	// Added and changed ticks, in the same order as entities()
+	const FDS_TickArray& ticks() const noexcept { return m_ticks; }
+
+	// The entity must be in the pool
+	const FDS_ComTicks& getTicks(FDS_EntityID id) const noexcept
+	{
+		return m_ticks[find(id)];
+	}
+
+	// Stamps the entity's component as written at tick, the entity must be in the pool
+	void touch(FDS_EntityID id, std::uint32_t tick) noexcept
+	{
+		m_ticks.touch(find(id), tick);
+	}
+
+	void setClock(const std::uint32_t* clock) noexcept
+	{
+		m_ticks.setClock(clock);
+	}
+
+	virtual void remove(FDS_EntityID id) = 0;
+	virtual void clear() noexcept = 0;
+
+	// Writes the entities, ticks and components as a snapshot block
+	virtual void save(FDS_SnapshotWriter& out) const = 0;
+
+	// Appends count entities of a block written by save(), none of them may be in the pool
+	virtual void load(FDS_SnapshotReader& in, std::size_t count) = 0;
+
+	// Adds a default-constructed component to each of count entities that do not have one yet
+	virtual void emplaceDefault(const FDS_EntityID* ids, std::size_t count) = 0;
+
+	// Type-erased address of the component in packed slot
+	virtual void* address(std::size_t slot) noexcept = 0;
+
+	// Owning group that orders the front of the packed arrays, or nullptr
+	const FDS_OwningGroup* getGroup() const noexcept { return m_group; }
+
+protected:
+	friend class FDS_EntityManager;
+	friend class FDS_OwningGroup;
+
+	virtual void swapComponents(std::uint32_t a, std::uint32_t b) = 0;
+
+	// Exchanges two packed slots, components, entities and ticks alike
+	void swapSlots(std::uint32_t a, std::uint32_t b)
+	{
+		if (a == b) return;
+		swapComponents(a, b);
+		std::swap(m_entities[a], m_entities[b]);
+		m_sparse[m_entities[a].index / PAGE_SIZE][m_entities[a].index % PAGE_SIZE] = a;
+		m_sparse[m_entities[b].index / PAGE_SIZE][m_entities[b].index % PAGE_SIZE] = b;
+		m_ticks.swap(a, b);
+	}
+
+
+	std::uint32_t find(FDS_EntityID id) const noexcept
+	{
+		const std::size_t page = id.index / PAGE_SIZE;
+		if (page >= m_sparse.size() || !m_sparse[page]) return NULL_SLOT;
+		return m_sparse[page][id.index % PAGE_SIZE];
+	}
+
+	std::uint32_t& slot(FDS_EntityID id)
+	{
+		const std::size_t page = id.index / PAGE_SIZE;
+		if (page >= m_sparse.size()) m_sparse.resize(page + 1);
+		if (!m_sparse[page])
+		{
+			m_sparse[page] = std::make_unique<std::uint32_t[]>(PAGE_SIZE);
+			std::fill_n(m_sparse[page].get(), PAGE_SIZE, NULL_SLOT);
+		}
+		return m_sparse[page][id.index % PAGE_SIZE];
+	}
+
+	// Moves the last packed entity into the removed slot, returns that slot
+	std::uint32_t swapOut(FDS_EntityID id) noexcept
+	{
+		const std::uint32_t removed = find(id);
+		const FDS_EntityID last = m_entities.back();
+		m_entities[removed] = last;
+		m_sparse[last.index / PAGE_SIZE][last.index % PAGE_SIZE] = removed;
+		m_sparse[id.index / PAGE_SIZE][id.index % PAGE_SIZE] = NULL_SLOT;
+		m_entities.pop_back();
+		m_ticks.swapRemove(removed);
+		return removed;
+	}
+
+protected:
+	std::vector<FDS_EntityID> m_entities;
+	FDS_TickArray m_ticks;
+	std::vector<std::unique_ptr<std::uint32_t[]>> m_sparse;
+	FDS_OwningGroup* m_group = nullptr;
+};
+
+/*
+	Owning group over sparse-set pools: the first size() packed slots of every
+	owned pool hold the entities that have all the owned types, in the same
+	order, so they are walked as parallel arrays without lookups. The pools
+	keep that order as components come and go. A pool is owned by at most one
+	group, see FDS_EntityManager::group().
+*/
+class FDS_OwningGroup
+{
+public:
+	std::size_t size() const noexcept { return m_size; }
+	const FDS_ComBitSet& signature() const noexcept { return m_signature; }
+
+	// Entities of the group, in packed order
+	const FDS_EntityID* entities() const noexcept { return m_pools.front()->entities().data(); }
+
+	bool contains(FDS_EntityID id) const noexcept
+	{
+		return m_pools.front()->contains(id) && m_pools.front()->find(id) < m_size;
+	}
+
+private:
+	friend class FDS_EntityManager;
+	template<typename> friend class FDS_ComPool;
+
+	// Moves id to the end of the group once it has every owned type
+	void add(FDS_EntityID id)
+	{
+		if (contains(id)) return;
+		for (FDS_ComPoolBase* pool : m_pools)
+		{
+			if (!pool->contains(id)) return;
+		}
+		for (FDS_ComPoolBase* pool : m_pools) pool->swapSlots(pool->find(id), static_cast<std::uint32_t>(m_size));
+		++m_size;
+	}
+
+	// Moves id just past the end of the group, before one of its components goes
+	void remove(FDS_EntityID id)
+	{
+		if (!contains(id)) return;
+		--m_size;
+		for (FDS_ComPoolBase* pool : m_pools) pool->swapSlots(pool->find(id), static_cast<std::uint32_t>(m_size));
+	}
+
+	void rebuild()
+	{
+		m_size = 0;
+		const FDS_ComPoolBase* smallest = m_pools.front();
+		for (const FDS_ComPoolBase* pool : m_pools)
+		{
+			if (pool->size() < smallest->size()) smallest = pool;
+		}
+		const std::vector<FDS_EntityID> candidates = smallest->entities();
+		for (FDS_EntityID id : candidates) add(id);
+	}
+
+private:
+	FDS_ComBitSet m_signature;
+	std::vector<FDS_ComPoolBase*> m_pools;
+	std::size_t m_size = 0;
+};
+
+template<typename T>
+class FDS_ComPool : public FDS_ComPoolBase
+{
+public:
+	template<typename... TArgs>
+	T& emplace(FDS_EntityID id, TArgs&&... mArgs)
+	{
+		m_components.emplace_back(std::forward<TArgs>(mArgs)...);
+		slot(id) = static_cast<std::uint32_t>(m_entities.size());
+		m_entities.push_back(id);
+		m_ticks.append(1);
+		if (!m_group) return m_components.back();
+
+		m_group->add(id);
+		return m_components[find(id)];
+	}
+
+	void emplaceDefault(const FDS_EntityID* ids, std::size_t count) override
+	{
+		if constexpr (std::is_default_constructible_v<T>)
+		{
+			emplaceMany(ids, count, T());
+		}
+		else
+		{
+			throw std::logic_error("FDS_ComPool: " + std::string(FDS_TypeName<T>()) + " is not default constructible");
+		}
+	}
+
+	// Adds a copy of prototype to each of count entities that do not have T yet
+	void emplaceMany(const FDS_EntityID* ids, std::size_t count, const T& prototype)
+	{
+		m_components.reserve(m_components.size() + count);
+		m_entities.reserve(m_entities.size() + count);
+		m_ticks.reserve(m_ticks.size() + count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			m_components.push_back(prototype);
+			slot(ids[i]) = static_cast<std::uint32_t>(m_entities.size());
+			m_entities.push_back(ids[i]);
+			m_ticks.append(1);
+		}
+		if (m_group)
+		{
+			for (std::size_t i = 0; i < count; ++i) m_group->add(ids[i]);
+		}
+	}
+
+	void remove(FDS_EntityID id) override
+	{
+		if (m_group) m_group->remove(id);
+		const std::uint32_t removed = swapOut(id);
+		if (removed != m_components.size() - 1) m_components[removed] = std::move(m_components.back());
+		m_components.pop_back();
+	}
+
+	void clear() noexcept override
+	{
+		for (FDS_EntityID id : m_entities) m_sparse[id.index / PAGE_SIZE][id.index % PAGE_SIZE] = NULL_SLOT;
+		m_entities.clear();
+		m_components.clear();
+		m_ticks.truncate(0);
+		if (m_group) m_group->m_size = 0;
+	}
+
+	void save(FDS_SnapshotWriter& out) const override
+	{
+		const FDS_ComTypeInfo& info = getComTypeInfo<T>();
+		if (!info.save) throw std::runtime_error("FDS_ComPool: " + std::string(info.name) + " needs an FDS_ComSerializer specialization");
+		out.write(m_entities.data(), m_entities.size() * sizeof(FDS_EntityID));
+		out.write(m_ticks.data(), m_ticks.size() * sizeof(FDS_ComTicks));
+		info.save(m_components.data(), m_components.size(), out);
+	}
+
+	void load(FDS_SnapshotReader& in, std::size_t count) override
+	{
+		if constexpr (std::is_default_constructible_v<T>)
+		{
+			const FDS_ComTypeInfo& info = getComTypeInfo<T>();
+			if (!info.load) throw std::runtime_error("FDS_ComPool: " + std::string(info.name) + " needs an FDS_ComSerializer specialization");
+
+			const std::byte* entities = in.take(count * sizeof(FDS_EntityID));
+			const std::byte* ticks = in.take(count * sizeof(FDS_ComTicks));
+			const std::size_t first = m_components.size();
+			m_components.resize(first + count);
+			try
+			{
+				info.load(m_components.data() + first, count, in);
+			}
+			catch (...)
+			{
+				m_components.resize(first);
+				throw;
+			}
+
+			m_entities.resize(first + count);
+			std::memcpy(m_entities.data() + first, entities, count * sizeof(FDS_EntityID));
+			for (std::size_t i = first; i < m_entities.size(); ++i) slot(m_entities[i]) = static_cast<std::uint32_t>(i);
+			m_ticks.appendBytes(ticks, count);
+			if (m_group)
+			{
+				const std::vector<FDS_EntityID> loaded(m_entities.begin() + first, m_entities.end());
+				for (FDS_EntityID id : loaded) m_group->add(id);
+			}
+		}
+		else
+		{
+			throw std::runtime_error("FDS_ComPool: " + std::string(FDS_TypeName<T>()) + " is not default constructible");
+		}
+	}
+
+	T& get(FDS_EntityID id) noexcept { return m_components[find(id)]; }
+
+	void* address(std::size_t slot) noexcept override { return &m_components[slot]; }
+
+	// Packed components, in the same order as entities()
+	T* data() noexcept { return m_components.data(); }
+
+protected:
+	void swapComponents(std::uint32_t a, std::uint32_t b) override
+	{
+		using std::swap;
+		swap(m_components[a], m_components[b]);
+	}
+
+private:
+	std::vector<T> m_components;
+};
+
+template<typename... Ts>
+class FDS_View;
+
+// Query filter: only entities whose T was written at or after tick since
+template<typename T>
+struct FDS_Changed
+{
+	std::uint32_t since = 0;
+};
+
+// Query filter: only entities that got T at or after tick since
+template<typename T>
+struct FDS_Added
+{
+	std::uint32_t since = 0;
+};
+
+// Query filter: only entities that also hold every one of Us, which are not passed to the callback
+template<typename... Us>
+struct FDS_With
+{
+};
+
+// Query filter: only entities that hold none of Us
+template<typename... Us>
+struct FDS_Without
+{
+};
+
+class FDS_ViewBase
+{
+public:
+	virtual ~FDS_ViewBase() = default;
+
+	// Picks up archetypes created since the last call
+	virtual void refresh() = 0;
+};
+
+/*
+	Component and resource types a system reads and writes. Two systems
+	conflict when one writes a type the other reads or writes; exclusive
+	systems conflict with all.
+*/
+class FDS_SystemAccess
+{
+public:
+	template<typename... Ts>
+	FDS_SystemAccess& read()
+	{
+		(m_reads.set(getComTypeID<std::remove_const_t<Ts>>()), ...);
+		return *this;
+	}
+
+	template<typename... Ts>
+	FDS_SystemAccess& write()
+	{
+		(m_writes.set(getComTypeID<std::remove_const_t<Ts>>()), ...);
+		return *this;
+	}
+
+	// A const T is a read, anything else a write
+	template<typename T>
+	FDS_SystemAccess& access()
+	{
+		return std::is_const_v<T> ? read<T>() : write<T>();
+	}
+
+	// World resources, see FDS_EntityManager::insertResource()
+	template<typename... Ts>
+	FDS_SystemAccess& readResource()
+	{
+		(m_resourceReads.set(getResourceID<std::remove_const_t<Ts>>()), ...);
+		return *this;
+	}
+
+	template<typename... Ts>
+	FDS_SystemAccess& writeResource()
+	{
+		(m_resourceWrites.set(getResourceID<std::remove_const_t<Ts>>()), ...);
+		return *this;
+	}
+
+	// The system may touch anything, e.g. make structural changes
+	FDS_SystemAccess& exclusive() noexcept
+	{
+		m_exclusive = true;
+		return *this;
+	}
+
+	bool conflicts(const FDS_SystemAccess& other) const noexcept
+	{
+		return m_exclusive || other.m_exclusive
+			|| m_writes.intersects(other.m_reads | other.m_writes)
+			|| other.m_writes.intersects(m_reads)
+			|| m_resourceWrites.intersects(other.m_resourceReads | other.m_resourceWrites)
+			|| other.m_resourceWrites.intersects(m_resourceReads);
+	}
+
+	const FDS_ComBitSet& getReads() const noexcept { return m_reads; }
+	const FDS_ComBitSet& getWrites() const noexcept { return m_writes; }
+	const FDS_ResourceBitSet& getResourceReads() const noexcept { return m_resourceReads; }
+	const FDS_ResourceBitSet& getResourceWrites() const noexcept { return m_resourceWrites; }
+	bool isExclusive() const noexcept { return m_exclusive; }
+
+private:
+	FDS_ComBitSet m_reads;
+	FDS_ComBitSet m_writes;
+	FDS_ResourceBitSet m_resourceReads;
+	FDS_ResourceBitSet m_resourceWrites;
+	bool m_exclusive = false;
+};
+
+/*
+	Bump allocator handing out memory from fixed-size blocks. Nothing is freed
+	individually, reset() releases everything at once and keeps the blocks
+	for reuse. Objects placed in it must be destroyed by the owner.
+*/
+class FDS_Arena
+{
+public:
+	explicit FDS_Arena(std::size_t blockSize = 64 * 1024) noexcept : m_blockSize(blockSize) {}
+
+	void* allocate(std::size_t size, std::size_t align)
+	{
+		for (; m_current < m_blocks.size(); ++m_current, m_offset = 0)
+		{
+			Block& block = m_blocks[m_current];
+			const std::size_t offset = alignOffset(block, m_offset, align);
+			if (offset + size <= block.size)
+			{
+				m_offset = offset + size;
+				return block.data.get() + offset;
+			}
+		}
+
+		const std::size_t blockSize = std::max(m_blockSize, size + align);
+		m_blocks.push_back({ std::make_unique<std::byte[]>(blockSize), blockSize });
+		m_current = m_blocks.size() - 1;
+		const std::size_t offset = alignOffset(m_blocks.back(), 0, align);
+		m_offset = offset + size;
+		return m_blocks.back().data.get() + offset;
+	}
+
+	template<typename T, typename... TArgs>
+	T* create(TArgs&&... mArgs)
+	{
+		return new (allocate(sizeof(T), alignof(T))) T(std::forward<TArgs>(mArgs)...);
+	}
+
+	void reset() noexcept
+	{
+		m_current = 0;
+		m_offset = 0;
+	}
+
+	// Bytes handed out since the last reset, not counting the unused tail of earlier blocks
+	std::size_t getBytesUsed() const noexcept
+	{
+		std::size_t used = m_offset;
+		for (std::size_t i = 0; i < m_current && i < m_blocks.size(); ++i) used += m_blocks[i].size;
+		return used;
+	}
+
+	std::size_t getCapacity() const noexcept
+	{
+		std::size_t capacity = 0;
+		for (const Block& block : m_blocks) capacity += block.size;
+		return capacity;
+	}
+
+private:
+	struct Block
+	{
+		std::unique_ptr<std::byte[]> data;
+		std::size_t size;
+	};
+
+	static std::size_t alignOffset(const Block& block, std::size_t offset, std::size_t align) noexcept
+	{
+		const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.data.get());
+		return ((base + offset + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1)) - base;
+	}
+
+	std::size_t m_blockSize;
+	std::vector<Block> m_blocks;
+	std::size_t m_current = 0;
+	std::size_t m_offset = 0;
+};
+
+/*
+	Fixed-size block allocator: pages of blocks threaded into a free list, so
+	allocating and freeing are a pointer swap and objects of one type end up
+	next to each other. Pages are only returned when the allocator is
+	destroyed, all at once.
+*/
+class FDS_PoolAllocator
+{
+public:
+	FDS_PoolAllocator(std::size_t blockSize, std::size_t align, std::size_t blocksPerPage = 256)
+		: m_align(std::max(align, alignof(FreeBlock))),
+		m_blockSize((std::max(blockSize, sizeof(FreeBlock)) + m_align - 1) / m_align * m_align),
+		m_blocksPerPage(blocksPerPage)
+	{
+	}
+
+	~FDS_PoolAllocator()
+	{
+		for (std::byte* page : m_pages) ::operator delete(page, std::align_val_t{ m_align });
+	}
+
+	FDS_PoolAllocator(const FDS_PoolAllocator&) = delete;
+	FDS_PoolAllocator& operator=(const FDS_PoolAllocator&) = delete;
+
+	void* allocate()
+	{
+		if (!m_free) addPage();
+
+		FreeBlock* block = m_free;
+		m_free = block->next;
+		++m_used;
+		++m_allocations;
+		return block;
+	}
+
+	void deallocate(void* ptr) noexcept
+	{
+		FreeBlock* block = static_cast<FreeBlock*>(ptr);
+		block->next = m_free;
+		m_free = block;
+		--m_used;
+	}
+
+	std::size_t getBlockSize() const noexcept { return m_blockSize; }
+	std::size_t getCapacity() const noexcept { return m_pages.size() * m_blocksPerPage; }
+	std::size_t getUsed() const noexcept { return m_used; }
+	std::size_t getPageCount() const noexcept { return m_pages.size(); }
+	std::size_t getAllocationCount() const noexcept { return m_allocations; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	void addPage()
+	{
+		std::byte* page = static_cast<std::byte*>(::operator new(m_blockSize * m_blocksPerPage, std::align_val_t{ m_align }));
+		m_pages.push_back(page);
+
+		// Threaded back to front so blocks are handed out in address order
+		for (std::size_t i = m_blocksPerPage; i-- > 0;)
+		{
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(page + i * m_blockSize);
+			block->next = m_free;
+			m_free = block;
+		}
+	}
+
+private:
+	std::size_t m_align;
+	std::size_t m_blockSize;
+	std::size_t m_blocksPerPage;
+	std::vector<std::byte*> m_pages;
+	FreeBlock* m_free = nullptr;
+	std::size_t m_used = 0;
+	std::size_t m_allocations = 0;
+};
+
+// Occupancy of one of a manager's pools, see FDS_EntityManager::getPoolStats()
+struct FDS_PoolStats
+{
+	std::string_view name;
+	std::size_t blockSize;
+	std::size_t capacity;
+	std::size_t used;
+	std::size_t pages;
+	std::size_t allocations;
+};
+
+// Returns pooled objects to their allocator, or deletes them when they were not pooled
+template<typename T>
+struct FDS_PoolDeleter
+{
+	FDS_PoolAllocator* pool = nullptr;
+
+	void operator()(T* ptr) const noexcept
+	{
+		if (!pool)
+		{
+			delete ptr;
+			return;
+		}
+
+		// Polymorphic objects may sit at an offset inside their block
+		void* block;
+		if constexpr (std::is_polymorphic_v<T>) block = dynamic_cast<void*>(ptr);
+		else block = ptr;
+		ptr->~T();
+		pool->deallocate(block);
+	}
+};
+
+using FDS_ComPtr = std::unique_ptr<FDS_Component, FDS_PoolDeleter<FDS_Component>>;
+using FDS_EntityPtr = std::unique_ptr<FDS_Entity, FDS_PoolDeleter<FDS_Entity>>;
+
+// Destroys a world resource as the type it was inserted with
+struct FDS_ResourceDeleter
+{
+	void (*destroy)(void*) = nullptr;
+
+	void operator()(void* ptr) const noexcept
+	{
+		destroy(ptr);
+	}
+};
+
+using FDS_ResourcePtr = std::unique_ptr<void, FDS_ResourceDeleter>;
+
+/*
+	Records structural changes to apply later with FDS_EntityManager::applyCommands(),
+	so systems can create and destroy entities or add and remove components while
+	entities are being iterated. Each thread records into its own buffer from
+	FDS_EntityManager::getCommandBuffer(), so recording takes no locks.
+*/
+class FDS_CommandBuffer
+{
+public:
+	explicit FDS_CommandBuffer(FDS_EntityManager& manager) noexcept : m_manager(&manager) {}
+
+	~FDS_CommandBuffer()
+	{
+		clear();
+	}
+
+	FDS_CommandBuffer(const FDS_CommandBuffer&) = delete;
+	FDS_CommandBuffer& operator=(const FDS_CommandBuffer&) = delete;
+
+	// The handle is valid immediately, the entity comes alive when commands are applied
+	FDS_EntityID createEntity();
+
+	void destroyEntity(FDS_EntityID id);
+
+	// Skipped if the entity, or for FDS_Parent the parent, is dead when applied
+	template<typename T, typename... TArgs>
+	void addComponent(FDS_EntityID id, TArgs&&... mArgs);
+
+	template<typename T>
+	void removeComponent(FDS_EntityID id);
+
+	bool empty() const noexcept { return m_commands.empty(); }
+	std::size_t size() const noexcept { return m_commands.size(); }
+
+	// Drops every recorded command without applying it
+	void clear() noexcept
+	{
+		for (Command& command : m_commands)
+		{
+			if (command.discard) command.discard(command.payload);
+		}
+		m_commands.clear();
+		m_payloads.reset();
+	}
+
+private:
+	friend class FDS_EntityManager;
+
+	struct Command
+	{
+		FDS_EntityID entity;
+		std::uint32_t sequence;
+		void (*apply)(FDS_EntityManager& manager, FDS_EntityID id, void* payload);
+		void (*discard)(void* payload);
+		void* payload;
+	};
+
+	void record(FDS_EntityID id, void (*apply)(FDS_EntityManager&, FDS_EntityID, void*), void (*discard)(void*) = nullptr, void* payload = nullptr)
+	{
+		m_commands.push_back({ id, static_cast<std::uint32_t>(m_commands.size()), apply, discard, payload });
+	}
+
+private:
+	FDS_EntityManager* m_manager;
+	std::thread::id m_thread;
+	std::vector<Command> m_commands;
+	FDS_Arena m_payloads;
+};
+
+/*
+	Observers of one component type. Slots receive every entity of a batch
+	in one call: construct and destroy batches are queued and delivered by
+	FDS_EntityManager::flushEvents(), update batches once per tick.
+*/
+struct FDS_ComSignals
+{
+	using Batch = fds::Signal<const std::vector<FDS_EntityID>&>;
+
+	Batch construct;
+	Batch destroy;
+	Batch update;
+
+private:
+	friend class FDS_EntityManager;
+
+	std::vector<FDS_EntityID> m_constructed;
+	std::vector<FDS_EntityID> m_destroyed;
+};
+
+/*
+	Legacy FDS_Component type whose update() and draw() run type by type
+	through qualified, non-virtual calls, see FDS_EntityManager::addComponentGroup()
+*/
+struct FDS_ComGroup
+{
+	FDS_ComID id;
+	std::string_view name;
+	std::vector<FDS_Component*> components;                // nullptr for those removed during a pass
+	void (*update)(FDS_Component* const* components, std::size_t count);
+	void (*draw)(FDS_Component* const* components, std::size_t count);
+};
+
+/*
+	Link to the entity's parent, set with FDS_EntityManager::setParent() or
+	addComponent. Write it only through those, a value changed in place is
+	not seen until the hierarchy is rebuilt for another reason.
+*/
+struct FDS_Parent
+{
+	FDS_EntityID entity;
+};
+
+/*
+	Entities linked by FDS_Parent in breadth-first order: level d holds every
+	entity of depth d, roots first, so a parent always precedes its children
+	and the children of one parent are adjacent. Nodes refer to each other by
+	position in the order, so propagation is one forward pass over an array,
+	and each level can be split across threads.
+*/
+class FDS_Hierarchy
+{
+public:
+	static constexpr std::uint32_t NO_PARENT = UINT32_MAX;
+
+	struct Node
+	{
+		FDS_EntityID entity;
+		std::uint32_t parent;        // position of the parent node, NO_PARENT for roots
+		std::uint32_t firstChild;
+		std::uint32_t childCount;
+	};
+
+	const std::vector<Node>& nodes() const noexcept { return m_nodes; }
+	std::size_t size() const noexcept { return m_nodes.size(); }
+	std::size_t levelCount() const noexcept { return m_levels.empty() ? 0 : m_levels.size() - 1; }
+
+	// Nodes of depth d are [levelBegin(d), levelBegin(d + 1))
+	std::size_t levelBegin(std::size_t depth) const noexcept { return m_levels[depth]; }
+
+private:
+	friend class FDS_EntityManager;
+
+	std::vector<Node> m_nodes;
+	std::vector<std::size_t> m_levels;
+};
+
+class FDS_Entity
+{
+public:
+	// Components of a type grouped in the entity's manager are left to the manager
+	void update();
+	void draw();
+
+	bool isActive() const noexcept
+	{
+		return m_isActive;
+	}
+
+	// The entity is released by the next FDS_EntityManager::refresh()
+	void destroy() noexcept;
+
+	// Handle of the entity in its manager, stays safe to store after the entity dies
+	FDS_EntityID getID() const noexcept
+	{
+		return m_id;
+	}
+
+	/*
+		Types derived from FDS_Component are owned by the entity as before,
+		any other type is stored in the manager's archetype storage. Adding a
+		type the entity already has replaces the component.
+	*/
+	template<typename T>
+	bool hasComponent() const;
+
+	template<typename T,typename... TArgs>
+	T& addComponent(TArgs&&... mArgs);
+
+	template<typename T>
+	T& getComponent() const;
+
+	// Does nothing if the entity has no T, an FDS_Component removed inside update() or draw() is destroyed after it
+	template<typename T>
+	void removeComponent();
+
+private:
+	friend class FDS_EntityManager;
+
+	FDS_EntityManager& requireManager() const
+	{
+		if (!m_manager) throw std::logic_error("FDS_Entity: data components require an entity created by FDS_EntityManager");
+		return *m_manager;
+	}
+
+	/*
+		While an update() or draw() pass may still reach the entity's
+		components, removed ones leave an empty slot and removed or replaced
+		ones are kept alive in m_retired; sweep() clears both after the pass.
+	*/
+	bool deferRemoval() const noexcept;
+	void endPass();
+	void sweep();
+
+private:
+	bool m_isActive = true;
+	std::uint32_t m_passes = 0;
+	std::vector<FDS_ComPtr> m_components = {};
+	std::vector<FDS_ComID> m_comIDs = {};                    // FDS_INVALID_COM for an empty slot
+	std::vector<FDS_ComPtr> m_retired = {};
+	FDS_ComBitSet m_comBitSet = {};
+	FDS_EntityManager* m_manager = nullptr;
+	FDS_EntityID m_id = FDS_NULL_ENTITY;
+};
+
+class FDS_EntityManager
+{
+public:
+	friend class FDS_Entity;
+	friend class FDS_RollbackBuffer;
+
+	FDS_EntityManager() : m_serial(nextSerial())
+	{
+		m_archetypes.emplace_back(std::make_unique<FDS_Archetype>(FDS_ComBitSet{}, std::vector<const FDS_ComTypeInfo*>{}, &m_tick));
+		m_archetypeMap.emplace(FDS_ComBitSet{}, m_archetypes.back().get());
+	}
+
+	// Entities keep a pointer back to their manager
+	FDS_EntityManager(const FDS_EntityManager&) = delete;
+	FDS_EntityManager& operator=(const FDS_EntityManager&) = delete;
+	FDS_EntityManager(FDS_EntityManager&&) = delete;
+	FDS_EntityManager& operator=(FDS_EntityManager&&) = delete;
+
+	/*
+		Runs the registered systems, applies the commands they recorded, then
+		updates every FDS_Entity's components and advances the tick. Entities
+		added during the loop are first updated next frame, components removed
+		or replaced during it are destroyed once it ends.
+	*/
+	void update()
+	{
+		FDS_Profiler* profiler = m_profiler.get();
+		if (profiler) profiler->beginFrame();
+
+		runSystems();
+		{
+			FDS_Profiler::Scope scope(profiler, "applyCommands");
+			applyCommands();
+		}
+		{
+			ComponentPass pass(*this);
+			if (profiler)
+			{
+				profileEntityUpdate(*profiler);
+			}
+			else
+			{
+				for (std::size_t i = 0, count = m_entities.size(); i < count; ++i) m_entities[i]->update();
+			}
+			for (FDS_ComGroup& group : m_groups)
+			{
+				FDS_Profiler::Scope scope(profiler, group.name);
+				FDS_Profiler::addEntities(group.components.size());
+				group.update(group.components.data(), group.components.size());
+			}
+		}
+		{
+			FDS_Profiler::Scope scope(profiler, "advanceTick");
+			advanceTick();
+		}
+
+		if (profiler) profiler->endFrame();
+	}
+
+	/*
+		Records every update() from now on: each system, applyCommands, each
+		FDS_Component type in the FDS_Entity pass and in its group, and
+		advanceTick get a sample per frame, named after the system or type.
+		Views add the entities they walk to the running system's sample.
+		Returns the profiler, which lives until disableProfiling().
+	*/
+	FDS_Profiler& enableProfiling(std::size_t window = FDS_Profiler::DEFAULT_WINDOW)
+	{
+		if (!m_profiler) m_profiler = std::make_unique<FDS_Profiler>(window);
+		return *m_profiler;
+	}
+
+	// Not while update() runs
+	void disableProfiling() noexcept
+	{
+		m_profiler.reset();
+	}
+
+	FDS_Profiler* getProfiler() const noexcept
+	{
+		return m_profiler.get();
+	}
+
+	/*
+		Data components are stamped with the current tick when they are added
+		and when they are written: through getComponent<T> or markChanged<T>,
+		or by a view iterating a non-const T. Remember the tick a system ran at
+		and pass it to FDS_Changed / FDS_Added to visit what happened since,
+		including writes later in that tick; those are visited again next time.
+	*/
+	std::uint32_t getTick() const noexcept
+	{
+		return m_tick;
+	}
+
+	// Delivers pending construct/destroy batches and this tick's update batches first
+	void advanceTick()
+	{
+		flushEvents();
+		emitUpdates();
+		++m_tick;
+	}
+
+	/*
+		Observers of T. construct and destroy batches are delivered by
+		flushEvents(), which createMany, destroyMany, applyCommands, refresh
+		and advanceTick call; destroyed handles are already dead by then.
+		update gets the entities whose T was written, but not added, during
+		the tick that advanceTick() ends. FDS_Component types only report
+		construct and destroy.
+	*/
+	template<typename T>
+	FDS_ComSignals::Batch& onConstruct()
+	{
+		return getSignals(getComTypeID<T>()).construct;
+	}
+
+	template<typename T>
+	FDS_ComSignals::Batch& onDestroy()
+	{
+		return getSignals(getComTypeID<T>()).destroy;
+	}
+
+	template<typename T>
+	FDS_ComSignals::Batch& onUpdate()
+	{
+		return getSignals(getComTypeID<T>()).update;
+	}
+
+	// One emission per component type and kind; batches queued by the slots are delivered too
+	void flushEvents()
+	{
+		while (m_pendingSignals.any())
+		{
+			const FDS_ComBitSet pending = m_pendingSignals;
+			m_pendingSignals.clear();
+			pending.forEach([&](FDS_ComID comID)
+				{
+					FDS_ComSignals& signals = *m_signals[comID];
+					std::vector<FDS_EntityID> batch;
+					batch.swap(signals.m_constructed);
+					if (!batch.empty()) signals.construct.emit(batch);
+
+					batch.clear();
+					batch.swap(signals.m_destroyed);
+					if (!batch.empty()) signals.destroy.emit(batch);
+				});
+		}
+	}
+
+	void draw()
+	{
+		ComponentPass pass(*this);
+		for (std::size_t i = 0, count = m_entities.size(); i < count; ++i) m_entities[i]->draw();
+		for (FDS_ComGroup& group : m_groups) group.draw(group.components.data(), group.components.size());
+	}
+
+	/*
+		Adapter for legacy FDS_Component types: every T of the manager's
+		entities is updated and drawn in one loop per type after the
+		per-entity pass, calling T::update() and T::draw() directly so the
+		compiler can inline them. Groups run in the order they were added.
+		Only components created as exactly T are grouped, derived types need
+		their own group. Plain-data components get this from systems and eachChunk().
+	*/
+	template<typename T>
+	void addComponentGroup()
+	{
+		static_assert(std::is_base_of_v<FDS_Component, T>, "Only FDS_Component types are grouped, plain-data types use systems");
+
+		const FDS_ComID comID = getComTypeID<T>();
+		if (m_grouped.test(comID)) return;
+
+		FDS_ComGroup group;
+		group.id = comID;
+		group.name = FDS_TypeName<T>();
+		group.update = [](FDS_Component* const* components, std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (components[i]) static_cast<T*>(components[i])->T::update();
+			}
+		};
+		group.draw = [](FDS_Component* const* components, std::size_t count)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (components[i]) static_cast<T*>(components[i])->T::draw();
+			}
+		};
+		for (const auto& e : m_entities)
+		{
+			for (std::size_t i = 0; i < e->m_comIDs.size(); ++i)
+			{
+				if (e->m_comIDs[i] == comID) group.components.push_back(e->m_components[i].get());
+			}
+		}
+
+		m_groups.push_back(std::move(group));
+		m_grouped.set(comID);
+	}
+
+	bool isComponentGrouped(FDS_ComID comID) const noexcept
+	{
+		return m_grouped.test(comID);
+	}
+
+	/*
+		Systems run on this pool, nullptr runs them serially on the calling thread.
+		The pool must outlive the manager or be reset before it is destroyed.
+	*/
+	void setJobSystem(FDS_JobSystem* jobs) noexcept
+	{
+		m_jobs = jobs;
+	}
+
+	FDS_JobSystem* getJobSystem() const noexcept
+	{
+		return m_jobs;
+	}
+
+	/*
+		Registers a system with the component types it reads and writes.
+		Systems that do not conflict run concurrently, conflicting ones keep
+		their registration order. Structural changes need an exclusive system.
+
+		A system running alongside others may only call view(), each(),
+		eachChunk(), parallelEach(), getComponent(), hasComponent(),
+		markChanged(), getTicks(), getSignature(), isAlive() and the resource
+		getters on its declared types, and record anything else into
+		getCommandBuffer(). A view over a sparse-set type creates its pool,
+		so the first one must come from an exclusive system or the caller.
+	*/
+	void addSystem(const std::string& name, const FDS_SystemAccess& access, std::function<void(FDS_EntityManager&)> func)
+	{
+		FDS_System system;
+		system.name = name;
+		system.access = access;
+		system.func = std::move(func);
+		m_systems.push_back(std::move(system));
+		m_systemGraphDirty = true;
+	}
+
+	// Exclusive system, it never runs alongside another one
+	void addSystem(const std::string& name, std::function<void(FDS_EntityManager&)> func)
+	{
+		addSystem(name, FDS_SystemAccess().exclusive(), std::move(func));
+	}
+
+	// Per-entity system over view<Ts...>, its access is derived from the constness of Ts
+	template<typename... Ts, typename Func, typename = std::enable_if_t<(sizeof...(Ts) > 0)>>
+	void addSystem(const std::string& name, Func func);
+
+	void runSystems()
+	{
+		if (m_systems.empty()) return;
+
+		if (!m_jobs || m_jobs->getThreadCount() == 0)
+		{
+			for (auto& system : m_systems) runSystem(system);
+			return;
+		}
+
+		if (m_systemGraphDirty) buildSystemGraph();
+		refreshViews();
+
+		std::vector<std::atomic<std::size_t>> pending(m_systems.size());
+		for (std::size_t i = 0; i < m_systems.size(); ++i) pending[i].store(m_systems[i].dependencies, std::memory_order_relaxed);
+
+		FDS_JobCounter counter;
+		std::function<void(std::size_t)> launch = [&](std::size_t index)
+		{
+			m_jobs->submit(counter, [&, index]()
+				{
+					runSystem(m_systems[index]);
+					if (m_systems[index].access.isExclusive()) refreshViews();
+					for (std::size_t next : m_systems[index].dependents)
+					{
+						if (pending[next].fetch_sub(1, std::memory_order_acq_rel) == 1) launch(next);
+					}
+				});
+		};
+
+		for (std::size_t i = 0; i < m_systems.size(); ++i)
+		{
+			if (m_systems[i].dependencies == 0) launch(i);
+		}
+		m_jobs->wait(counter);
+	}
+
+	// Releases entities whose destroy() was called, free when none were
+	void refresh()
+	{
+		if (m_pendingDestroy.exchange(0, std::memory_order_acq_rel) == 0) return;
+
+		for (auto& e : m_entities)
+		{
+			if (e->isActive()) continue;
+			for (FDS_ComID comID : e->m_comIDs)
+			{
+				if (comID != FDS_INVALID_COM) queueDestroy(comID, e->m_id);
+			}
+			destroyEntity(e->m_id);
+		}
+
+		for (FDS_ComGroup& group : m_groups)
+		{
+			group.components.erase(
+				std::remove_if(group.components.begin(), group.components.end(), [](const FDS_Component* com) { return !com || !com->owner->isActive(); }),
+				group.components.end());
+		}
+
+		m_entities.erase(
+			std::remove_if
+			(
+				std::begin(m_entities),
+				std::end(m_entities),
+				[](const FDS_EntityPtr& mEntity) {return !mEntity->isActive();}
+			),
+			std::end(m_entities)
+		);
+		flushEvents();
+	}
+
+	FDS_Entity& addEntity()
+	{
+		FDS_Entity* e = new (m_entityAllocator.allocate()) FDS_Entity();
+		FDS_EntityPtr uPtr{ e, { &m_entityAllocator } };
+		e->m_manager = this;
+		e->m_id = createEntity();
+		m_records[e->m_id.index].entity = e;
+		m_entities.emplace_back(std::move(uPtr));
+		return *e;
+	}
+
+	// Creates an entity that only lives in the archetype storage, recycling a free slot if any
+	FDS_EntityID createEntity()
+	{
+		flushReserved();
+
+		std::uint32_t index;
+		if (!m_freeList.empty())
+		{
+			index = m_freeList.back();
+			m_freeList.pop_back();
+			m_freeCursor.store(static_cast<std::int64_t>(m_freeList.size()), std::memory_order_relaxed);
+		}
+		else
+		{
+			index = static_cast<std::uint32_t>(m_records.size());
+			m_records.emplace_back();
+		}
+		return spawn(index);
+	}
+
+	/*
+		Hands out a handle without touching the entity table, safe to call from
+		any thread while no other structural change runs. The entity comes alive
+		at the next createEntity, destroyEntity or applyCommands.
+	*/
+	FDS_EntityID reserveEntity() noexcept
+	{
+		const std::int64_t cursor = m_freeCursor.fetch_sub(1, std::memory_order_relaxed);
+		if (cursor > 0)
+		{
+			const std::uint32_t index = m_freeList[static_cast<std::size_t>(cursor - 1)];
+			return { index, m_records[index].generation };
+		}
+		return { static_cast<std::uint32_t>(m_records.size() + static_cast<std::size_t>(-cursor)), 0 };
+	}
+
+	/*
+		Creates count entities holding a default-constructed component for every
+		bit of signature. Each column grows once and the components are built
+		back to back, handles come back in row order.
+	*/
+	std::vector<FDS_EntityID> createMany(std::size_t count, const FDS_ComBitSet& signature)
+	{
+		flushReserved();
+
+		FDS_ComBitSet table;
+		std::vector<const FDS_ComTypeInfo*> sparse;
+		signature.forEach([&](FDS_ComID comID)
+			{
+				const FDS_ComTypeInfo* info = FDS_ComRegistry::instance().find(comID);
+				if (!info) throw std::invalid_argument("FDS_EntityManager::createMany: component id " + std::to_string(comID) + " is not registered");
+				if (!info->construct) throw std::logic_error("FDS_EntityManager::createMany: " + std::string(info->name) + " is not default constructible");
+
+				if (info->storage == FDS_ComStorage::SparseSet)
+				{
+					sparse.push_back(info);
+				}
+				else
+				{
+					m_comInfos[comID] = info;
+					table.set(comID);
+				}
+			});
+
+		FDS_Archetype& archetype = *findOrCreateArchetype(table);
+		fillColumns(archetype, [count](FDS_Column& col) { col.emplaceDefault(count); });
+
+		std::vector<FDS_EntityID> ids = spawnMany(archetype, count);
+		for (const FDS_ComTypeInfo* info : sparse) getPool(*info).emplaceDefault(ids.data(), count);
+
+		(signature & m_observed).forEach([&](FDS_ComID comID) { queueConstruct(comID, ids); });
+		flushEvents();
+		return ids;
+	}
+
+	// Creates count entities holding a copy of each prototype
+	template<typename... Ts>
+	std::vector<FDS_EntityID> createMany(std::size_t count, const Ts&... prototypes)
+	{
+		static_assert(!(std::is_base_of_v<FDS_Component, Ts> || ...), "FDS_Component types are owned by FDS_Entity");
+		static_assert((std::is_copy_constructible_v<Ts> && ...), "createMany copies its prototypes");
+
+		flushReserved();
+
+		FDS_ComBitSet table;
+		(addTableBit<Ts>(table), ...);
+
+		FDS_Archetype& archetype = *findOrCreateArchetype(table);
+		if constexpr (sizeof...(Ts) > 0)
+		{
+			fillColumns(archetype, [&](FDS_Column& col)
+				{
+					const void* prototype = nullptr;
+					((col.info().id == getComTypeID<Ts>() ? prototype = &prototypes : nullptr), ...);
+					col.emplaceCopies(prototype, count);
+				});
+		}
+
+		std::vector<FDS_EntityID> ids = spawnMany(archetype, count);
+		(emplacePooled(ids, prototypes), ...);
+		if constexpr ((std::is_same_v<Ts, FDS_Parent> || ...)) m_hierarchyDirty = true;
+
+		(queueConstruct(getComTypeID<Ts>(), ids), ...);
+		flushEvents();
+		return ids;
+	}
+
+	// Stale handles are ignored
+	void destroyEntity(FDS_EntityID id)
+	{
+		flushReserved();
+		if (!isAlive(id)) return;
+		FDS_EntityRecord& record = m_records[id.index];
+
+		m_poolMask.forEach([&](FDS_ComID comID)
+			{
+				if (!m_pools[comID]->contains(id)) return;
+				queueDestroy(comID, id);
+				m_pools[comID]->remove(id);
+			});
+
+		(record.archetype->m_signature & m_observed).forEach([&](FDS_ComID comID) { queueDestroy(comID, id); });
+		for (FDS_Column& col : record.archetype->m_columns) col.swapRemove(record.row);
+		removeRow(*record.archetype, record.row);
+		release(id.index);
+		m_freeCursor.store(static_cast<std::int64_t>(m_freeList.size()), std::memory_order_relaxed);
+	}
+
+	/*
+		Destroys every live entity in ids, stale and repeated handles are ignored.
+		Rows are removed per archetype from the back, one column at a time.
+	*/
+	void destroyMany(const FDS_EntityID* ids, std::size_t count)
+	{
+		flushReserved();
+
+		struct Doomed
+		{
+			FDS_Archetype* archetype;
+			std::uint32_t row;
+		};
+		std::vector<Doomed> doomed;
+		doomed.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (isAlive(ids[i])) doomed.push_back({ m_records[ids[i].index].archetype, m_records[ids[i].index].row });
+		}
+		if (doomed.empty()) return;
+
+		std::sort(doomed.begin(), doomed.end(), [](const Doomed& a, const Doomed& b)
+			{
+				if (a.archetype != b.archetype) return std::less<FDS_Archetype*>()(a.archetype, b.archetype);
+				return a.row > b.row;
+			});
+		doomed.erase(std::unique(doomed.begin(), doomed.end(), [](const Doomed& a, const Doomed& b)
+			{
+				return a.archetype == b.archetype && a.row == b.row;
+			}), doomed.end());
+
+		m_poolMask.forEach([&](FDS_ComID comID)
+			{
+				FDS_ComPoolBase& pool = *m_pools[comID];
+				for (const Doomed& entry : doomed)
+				{
+					if (pool.empty()) break;
+					const FDS_EntityID id = entry.archetype->m_entities[entry.row];
+					if (!pool.contains(id)) continue;
+					queueDestroy(comID, id);
+					pool.remove(id);
+				}
+			});
+
+		// Removing in descending row order never moves a row that is still to be removed
+		for (std::size_t begin = 0, end; begin < doomed.size(); begin = end)
+		{
+			FDS_Archetype& archetype = *doomed[begin].archetype;
+			for (end = begin; end < doomed.size() && doomed[end].archetype == &archetype; ++end) {}
+
+			(archetype.m_signature & m_observed).forEach([&](FDS_ComID comID)
+				{
+					for (std::size_t i = begin; i < end; ++i) queueDestroy(comID, archetype.m_entities[doomed[i].row]);
+				});
+
+			for (FDS_Column& col : archetype.m_columns)
+			{
+				for (std::size_t i = begin; i < end; ++i) col.swapRemove(doomed[i].row);
+			}
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				const std::uint32_t index = archetype.m_entities[doomed[i].row].index;
+				removeRow(archetype, doomed[i].row);
+				release(index);
+			}
+		}
+		m_freeCursor.store(static_cast<std::int64_t>(m_freeList.size()), std::memory_order_relaxed);
+		flushEvents();
+	}
+
+	void destroyMany(const std::vector<FDS_EntityID>& ids)
+	{
+		destroyMany(ids.data(), ids.size());
+	}
+
+	/*
+		Command buffer of the calling thread. Each thread caches the buffers of
+		its last few managers, older entries and those of destroyed managers
+		are overwritten; only a miss locks.
+	*/
+	FDS_CommandBuffer& getCommandBuffer()
+	{
+		struct Cached
+		{
+			std::uint64_t serial = 0;
+			FDS_CommandBuffer* buffer = nullptr;
+		};
+		thread_local std::array<Cached, 4> cache;
+		thread_local std::size_t next = 0;
+
+		for (const Cached& cached : cache)
+		{
+			if (cached.serial == m_serial) return *cached.buffer;
+		}
+
+		const std::thread::id thread = std::this_thread::get_id();
+		std::lock_guard<std::mutex> lock(m_commandMutex);
+		FDS_CommandBuffer* buffer = nullptr;
+		for (auto& owned : m_commandBuffers)
+		{
+			if (owned->m_thread == thread) buffer = owned.get();
+		}
+		if (!buffer)
+		{
+			m_commandBuffers.push_back(std::make_unique<FDS_CommandBuffer>(*this));
+			buffer = m_commandBuffers.back().get();
+			buffer->m_thread = thread;
+		}
+
+		cache[next] = { m_serial, buffer };
+		next = (next + 1) % cache.size();
+		return *buffer;
+	}
+
+	/*
+		Applies every thread's recorded commands in one pass, sorted by entity
+		so each entity's changes are applied together and in recording order.
+		Must not run while any thread is still recording. If a command throws,
+		the remaining ones are dropped so nothing is applied twice.
+	*/
+	void applyCommands()
+	{
+		flushReserved();
+
+		struct Sorted
+		{
+			FDS_CommandBuffer::Command* command;
+			std::size_t buffer;
+		};
+		std::vector<Sorted> sorted;
+		for (std::size_t b = 0; b < m_commandBuffers.size(); ++b)
+		{
+			for (auto& command : m_commandBuffers[b]->m_commands) sorted.push_back({ &command, b });
+		}
+		if (sorted.empty()) return;
+
+		std::sort(sorted.begin(), sorted.end(), [](const Sorted& a, const Sorted& b)
+			{
+				if (a.command->entity.index != b.command->entity.index) return a.command->entity.index < b.command->entity.index;
+				if (a.buffer != b.buffer) return a.buffer < b.buffer;
+				return a.command->sequence < b.command->sequence;
+			});
+
+		try
+		{
+			for (const Sorted& entry : sorted)
+			{
+				FDS_CommandBuffer::Command& command = *entry.command;
+				command.apply(*this, command.entity, command.payload);
+				command.discard = nullptr;
+			}
+		}
+		catch (...)
+		{
+			for (auto& buffer : m_commandBuffers) buffer->clear();
+			throw;
+		}
+		for (auto& buffer : m_commandBuffers) buffer->clear();
+		flushEvents();
+	}
+
+	bool isAlive(FDS_EntityID id) const noexcept
+	{
+		return id.index < m_records.size() && m_records[id.index].generation == id.generation && m_records[id.index].archetype;
+	}
+
+	// Entity created by addEntity(), nullptr if the handle is stale or has no FDS_Entity
+	FDS_Entity* getEntity(FDS_EntityID id) const noexcept
+	{
+		return isAlive(id) ? m_records[id.index].entity : nullptr;
+	}
+
+	/*
+		Adding a component the entity already has replaces its value, stale
+		handles throw. FDS_Parent goes through setParent() for its checks.
+	*/
+	template<typename T, typename... TArgs>
+	T& addComponent(FDS_EntityID id, TArgs&&... mArgs)
+	{
+		static_assert(!std::is_base_of_v<FDS_Component, T>, "FDS_Component types are owned by FDS_Entity");
+
+		if constexpr (std::is_same_v<T, FDS_Parent>)
+		{
+			setParent(id, FDS_Parent{ std::forward<TArgs>(mArgs)... }.entity);
+			return getComponent<FDS_Parent>(id);
+		}
+		else return emplaceComponent<T>(id, std::forward<TArgs>(mArgs)...);
+	}
+
+	template<typename T>
+	void removeComponent(FDS_EntityID id)
+	{
+		if (!hasComponent<T>(id)) return;
+
+		if constexpr (std::is_same_v<T, FDS_Parent>) m_hierarchyDirty = true;
+		queueDestroy(getComTypeID<T>(), id);
+		if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			++m_structure;
+			m_pools[getComTypeID<T>()]->remove(id);
+		}
+		else
+		{
+			FDS_Archetype* dst = removeEdge(*m_records[id.index].archetype, getComTypeID<T>());
+			moveEntity(id, *dst);
+		}
+	}
+
+	/*
+		addComponent for every live entity in ids with a copy of prototype,
+		stale and repeated handles are ignored. Entities are moved per source
+		archetype one column at a time, see migrateMany().
+	*/
+	template<typename T>
+	void addComponents(const FDS_EntityID* ids, std::size_t count, const T& prototype = T())
+	{
+		static_assert(!std::is_base_of_v<FDS_Component, T>, "FDS_Component types are owned by FDS_Entity");
+		static_assert(std::is_copy_constructible_v<T>, "addComponents copies its prototype");
+
+		flushReserved();
+		if constexpr (std::is_same_v<T, FDS_Parent>)
+		{
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (isAlive(ids[i])) setParent(ids[i], prototype.entity);
+			}
+			return;
+		}
+
+		std::vector<FDS_EntityID> added;
+		std::vector<FDS_EntityID> replaced;
+		added.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (!isAlive(ids[i])) continue;
+			if (!hasComponent<T>(ids[i])) added.push_back(ids[i]);
+			else if constexpr (!FDS_IS_TAG_COM<T>)
+			{
+				getComponent<T>(ids[i]) = prototype;
+				replaced.push_back(ids[i]);
+			}
+		}
+		if (!replaced.empty())
+		{
+			uniqueAlive(replaced);
+			for (FDS_EntityID id : replaced) queueDestroy(getComTypeID<T>(), id);
+			flushEvents();
+			queueConstruct(getComTypeID<T>(), replaced);
+		}
+		uniqueAlive(added);
+		if (added.empty())
+		{
+			flushEvents();
+			return;
+		}
+
+		if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			++m_structure;
+			getPool<T>().emplaceMany(added.data(), added.size(), prototype);
+		}
+		else
+		{
+			const FDS_ComTypeInfo& info = getComTypeInfo<T>();
+			migrateMany(added, [&](FDS_Archetype& src) { return addEdge(src, info); }, [&](FDS_Archetype& dst, std::size_t moved)
+				{
+					if (FDS_Column* col = dst.findColumn(info.id)) col->emplaceCopies(&prototype, moved);
+				});
+		}
+
+		queueConstruct(getComTypeID<T>(), added);
+		flushEvents();
+	}
+
+	template<typename T>
+	void addComponents(const std::vector<FDS_EntityID>& ids, const T& prototype = T())
+	{
+		addComponents<T>(ids.data(), ids.size(), prototype);
+	}
+
+	// removeComponent for every entity in ids, moved like addComponents()
+	template<typename T>
+	void removeComponents(const FDS_EntityID* ids, std::size_t count)
+	{
+		flushReserved();
+
+		std::vector<FDS_EntityID> removed;
+		removed.reserve(count);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (hasComponent<T>(ids[i])) removed.push_back(ids[i]);
+		}
+		uniqueAlive(removed);
+		if (removed.empty()) return;
+
+		if constexpr (std::is_same_v<T, FDS_Parent>) m_hierarchyDirty = true;
+		for (FDS_EntityID id : removed) queueDestroy(getComTypeID<T>(), id);
+		if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			++m_structure;
+			for (FDS_EntityID id : removed) m_pools[getComTypeID<T>()]->remove(id);
+		}
+		else
+		{
+			migrateMany(removed, [this](FDS_Archetype& src) { return removeEdge(src, getComTypeID<T>()); }, [](FDS_Archetype&, std::size_t) {});
+		}
+		flushEvents();
+	}
+
+	template<typename T>
+	void removeComponents(const std::vector<FDS_EntityID>& ids)
+	{
+		removeComponents<T>(ids.data(), ids.size());
+	}
+
+	template<typename T>
+	bool hasComponent(FDS_EntityID id) const
+	{
+		if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			const auto& pool = m_pools[getComTypeID<T>()];
+			return pool && pool->contains(id);
+		}
+		else
+		{
+			return isAlive(id) && m_records[id.index].archetype->m_signature[getComTypeID<T>()];
+		}
+	}
+
+	// getComponent<const T> reads without marking the component changed, the entity must have T
+	template<typename T>
+	T& getComponent(FDS_EntityID id) const
+	{
+		using U = std::remove_const_t<T>;
+		assert(hasComponent<U>(id));
+		if constexpr (!std::is_const_v<T>) markChanged<U>(id);
+
+		if constexpr (FDS_ComTraits<U>::storage == FDS_ComStorage::SparseSet)
+		{
+			return static_cast<FDS_ComPool<U>&>(*m_pools[getComTypeID<U>()]).get(id);
+		}
+		else if constexpr (FDS_IS_TAG_COM<U>)
+		{
+			return FDS_TagInstance<U>();
+		}
+		else
+		{
+			const FDS_EntityRecord& record = m_records[id.index];
+			return record.archetype->column<U>()[record.row];
+		}
+	}
+
+	// Stamps the entity's T as written in the current tick, for writes through a kept reference
+	template<typename T>
+	void markChanged(FDS_EntityID id) const
+	{
+		if constexpr (FDS_IS_TAG_COM<T>) return;
+		else if (!hasComponent<T>(id)) return;
+		else if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			m_pools[getComTypeID<T>()]->touch(id, m_tick);
+		}
+		else
+		{
+			const FDS_EntityRecord& record = m_records[id.index];
+			record.archetype->findColumn(getComTypeID<T>())->ticks().touch(record.row, m_tick);
+		}
+	}
+
+	// Tags, stale handles and missing components report zero ticks
+	template<typename T>
+	FDS_ComTicks getTicks(FDS_EntityID id) const
+	{
+		if constexpr (FDS_IS_TAG_COM<T>) return {};
+		else if (!hasComponent<T>(id)) return {};
+		else if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			return m_pools[getComTypeID<T>()]->getTicks(id);
+		}
+		else
+		{
+			const FDS_EntityRecord& record = m_records[id.index];
+			return record.archetype->findColumn(getComTypeID<T>())->ticks()[record.row];
+		}
+	}
+
+	// Archetype signature plus the bits of every sparse-set pool holding the entity
+	FDS_ComBitSet getSignature(FDS_EntityID id) const noexcept
+	{
+		if (!isAlive(id)) return {};
+		FDS_ComBitSet signature = m_records[id.index].archetype->m_signature;
+		m_poolMask.forEach([&](FDS_ComID comID)
+			{
+				if (m_pools[comID]->contains(id)) signature.set(comID);
+			});
+		return signature;
+	}
+
+	template<typename T>
+	FDS_ComPool<T>& getPool()
+	{
+		static_assert(FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet, "T is not stored in a sparse-set pool");
+
+		auto& pool = m_pools[getComTypeID<T>()];
+		if (!pool)
+		{
+			pool = std::make_unique<FDS_ComPool<T>>();
+			pool->setClock(&m_tick);
+			m_poolMask.set(getComTypeID<T>());
+		}
+		return static_cast<FDS_ComPool<T>&>(*pool);
+	}
+
+	// Pool the FDS_Component objects of one type are allocated from
+	FDS_PoolAllocator& getComAllocator(const FDS_ComTypeInfo& info)
+	{
+		auto& allocator = m_comAllocators[info.id];
+		if (!allocator) allocator = std::make_unique<FDS_PoolAllocator>(info.size, info.align);
+		return *allocator;
+	}
+
+	/*
+		Arena for data that lives as long as the world, everything in it is
+		released at once when the manager is destroyed. Objects placed in it
+		are not destroyed.
+	*/
+	FDS_Arena& getArena() noexcept
+	{
+		return m_arena;
+	}
+
+	// Occupancy of the FDS_Entity pool followed by every FDS_Component pool in use
+	std::vector<FDS_PoolStats> getPoolStats() const
+	{
+		std::vector<FDS_PoolStats> stats;
+		stats.push_back(makePoolStats("FDS_Entity", m_entityAllocator));
+		for (FDS_ComID id = 0; id < FDS_MAX_COM; ++id)
+		{
+			if (m_comAllocators[id]) stats.push_back(makePoolStats(FDS_ComRegistry::instance().find(id)->name, *m_comAllocators[id]));
+		}
+		return stats;
+	}
+
+	/*
+		Creates the world's single T, replacing any previous one. Resources
+		hold global data such as settings or the frame clock; they are
+		indexed by a per-type id, so getResource() is one array load. They
+		are not part of snapshots.
+	*/
+	template<typename T, typename... TArgs>
+	T& insertResource(TArgs&&... mArgs)
+	{
+		const FDS_ResourceID id = getResourceID<T>();
+		T* resource = new T(std::forward<TArgs>(mArgs)...);
+		m_resources[id] = FDS_ResourcePtr(resource, { [](void* ptr) { delete static_cast<T*>(ptr); } });
+		return *resource;
+	}
+
+	// The resource must have been inserted
+	template<typename T>
+	T& getResource() const
+	{
+		return *static_cast<T*>(m_resources[getResourceID<T>()].get());
+	}
+
+	template<typename T>
+	T* findResource() const
+	{
+		return static_cast<T*>(m_resources[getResourceID<T>()].get());
+	}
+
+	template<typename T>
+	bool hasResource() const
+	{
+		return m_resources[getResourceID<T>()] != nullptr;
+	}
+
+	template<typename T>
+	void removeResource()
+	{
+		m_resources[getResourceID<T>()].reset();
+	}
+
+	// Archetypes are never removed, so indices into this list stay stable
+	const std::vector<std::unique_ptr<FDS_Archetype>>& getArchetypes() const noexcept
+	{
+		return m_archetypes;
+	}
+
+	/*
+		Cached query over every entity holding all of Ts, created on first use.
+		A const T in Ts gives read-only access to that component.
+	*/
+	template<typename... Ts>
+	FDS_View<Ts...>& view();
+
+	/*
+		Calls func(Ts&...) or func(FDS_EntityID, Ts&...) for each match.
+		Do not create or destroy entities or add/remove components inside func.
+	*/
+	template<typename... Ts, typename Func>
+	void each(Func&& func)
+	{
+		view<Ts...>().each(std::forward<Func>(func));
+	}
+
+	/*
+		Makes parent the parent of child, replacing any previous one. Throws
+		std::logic_error if either is dead or the link would close a cycle.
+		Children of a destroyed entity become roots.
+	*/
+	void setParent(FDS_EntityID child, FDS_EntityID parent)
+	{
+		if (!isAlive(child) || !isAlive(parent)) throw std::logic_error("FDS_EntityManager::setParent: dead entity");
+		for (FDS_EntityID ancestor = parent; !ancestor.isNull(); ancestor = getParent(ancestor))
+		{
+			if (ancestor == child) throw std::logic_error("FDS_EntityManager::setParent: the link would create a cycle");
+		}
+
+		emplaceComponent<FDS_Parent>(child, FDS_Parent{ parent });
+		m_hierarchyDirty = true;
+	}
+
+	void removeParent(FDS_EntityID child)
+	{
+		removeComponent<FDS_Parent>(child);
+	}
+
+	// FDS_NULL_ENTITY for roots and entities outside the hierarchy
+	FDS_EntityID getParent(FDS_EntityID child) const
+	{
+		if (!hasComponent<FDS_Parent>(child)) return FDS_NULL_ENTITY;
+		const FDS_EntityID parent = getComponent<const FDS_Parent>(child).entity;
+		return isAlive(parent) ? parent : FDS_NULL_ENTITY;
+	}
+
+	// Depth-sorted order of every linked entity, rebuilt after links changed
+	const FDS_Hierarchy& getHierarchy()
+	{
+		if (m_hierarchyDirty) buildHierarchy();
+		return m_hierarchy;
+	}
+
+	/*
+		Calls func(const Local& local, const World* parentWorld, World& world)
+		for every node of the hierarchy, parents before children, in one pass
+		over the depth-sorted order. parentWorld is nullptr for roots and for
+		children of nodes lacking Local or World, which are skipped.
+	*/
+	template<typename Local, typename World, typename Func>
+	void propagate(Func&& func)
+	{
+		const FDS_Hierarchy& hierarchy = getHierarchy();
+		std::vector<World*> worlds(hierarchy.size(), nullptr);
+		propagateRange<Local, World>(func, worlds, 0, hierarchy.size());
+	}
+
+	/*
+		propagate() with every depth level split over the job system; levels
+		run one after another, so func must only be safe to call concurrently
+		for different nodes. Levels of no more than minGrain nodes stay on the
+		calling thread.
+	*/
+	template<typename Local, typename World, typename Func>
+	void parallelPropagate(Func&& func, std::size_t minGrain = FDS_DEFAULT_GRAIN)
+	{
+		const FDS_Hierarchy& hierarchy = getHierarchy();
+		std::vector<World*> worlds(hierarchy.size(), nullptr);
+
+		for (std::size_t depth = 0; depth < hierarchy.levelCount(); ++depth)
+		{
+			const std::size_t begin = hierarchy.levelBegin(depth);
+			const std::size_t end = hierarchy.levelBegin(depth + 1);
+			if (!m_jobs || m_jobs->getThreadCount() == 0 || end - begin <= minGrain)
+			{
+				propagateRange<Local, World>(func, worlds, begin, end);
+				continue;
+			}
+
+			const std::size_t chunk = std::max(minGrain, (end - begin) / ((m_jobs->getThreadCount() + 1) * 4));
+			FDS_JobCounter counter;
+			for (std::size_t first = begin; first < end; first += chunk)
+			{
+				const std::size_t last = std::min(first + chunk, end);
+				m_jobs->submit(counter, [this, &func, &worlds, first, last]() { propagateRange<Local, World>(func, worlds, first, last); });
+			}
+			m_jobs->wait(counter);
+		}
+	}
+
+	/*
+		Writes every data component, entity handle and tick of the world as
+		one block per archetype column and sparse-set pool, memcpy for trivially
+		copyable types and FDS_ComSerializer for the others. Components are
+		identified by type hash, so ids may differ between the saving and the
+		loading process. FDS_Entity objects and their FDS_Component types are
+		not part of snapshots.
+	*/
+	void saveSnapshot(FDS_SnapshotWriter& out)
+	{
+		flushReserved();
+
+		std::size_t bytes = m_records.size() * 4 + m_freeList.size() * 4;
+		std::uint32_t archetypes = 0;
+		for (const auto& archetype : m_archetypes)
+		{
+			if (!archetype->size()) continue;
+			++archetypes;
+			bytes += archetype->size() * sizeof(FDS_EntityID);
+			for (const FDS_Column& col : archetype->m_columns) bytes += archetype->size() * (col.info().size + sizeof(FDS_ComTicks));
+		}
+		std::uint32_t pools = 0;
+		m_poolMask.forEach([&](FDS_ComID comID) { if (!m_pools[comID]->empty()) ++pools; });
+		out.reserve(out.size() + bytes);
+
+		out.write(SNAPSHOT_MAGIC);
+		out.write(SNAPSHOT_VERSION);
+		out.write(m_tick);
+		out.write(static_cast<std::uint32_t>(m_records.size()));
+		out.write(static_cast<std::uint32_t>(m_freeList.size()));
+		out.write(archetypes);
+		out.write(pools);
+
+		std::vector<std::uint32_t> generations(m_records.size());
+		for (std::size_t i = 0; i < m_records.size(); ++i) generations[i] = m_records[i].generation;
+		out.write(generations.data(), generations.size() * sizeof(std::uint32_t));
+		out.write(m_freeList.data(), m_freeList.size() * sizeof(std::uint32_t));
+
+		for (const auto& archetype : m_archetypes)
+		{
+			if (!archetype->size()) continue;
+			// Column types in column order, then the tags, which have no data
+			out.write(static_cast<std::uint32_t>(archetype->m_signature.count()));
+			out.write(static_cast<std::uint32_t>(archetype->size()));
+			for (const FDS_Column& col : archetype->m_columns) out.write(col.info().hash);
+			archetype->m_signature.forEach([&](FDS_ComID comID)
+				{
+					if (!archetype->findColumn(comID)) out.write(m_comInfos[comID]->hash);
+				});
+			out.write(archetype->m_entities.data(), archetype->size() * sizeof(FDS_EntityID));
+			for (const FDS_Column& col : archetype->m_columns) col.save(out);
+		}
+
+		m_poolMask.forEach([&](FDS_ComID comID)
+			{
+				const FDS_ComPoolBase& pool = *m_pools[comID];
+				if (pool.empty()) return;
+				out.write(FDS_ComRegistry::instance().find(comID)->hash);
+				out.write(static_cast<std::uint32_t>(pool.size()));
+				pool.save(out);
+			});
+	}
+
+	void saveSnapshot(const std::string& path)
+	{
+		FDS_SnapshotWriter out;
+		saveSnapshot(out);
+		out.saveFile(path);
+	}
+
+	/*
+		Replaces the whole world with a snapshot. Columns are filled one block
+		at a time into the storage the world already has, so loading allocates
+		per archetype and pool rather than per entity, and not at all when the
+		world already had the room. Every component type in the snapshot must
+		be registered. Throws std::runtime_error for a bad snapshot, leaving the
+		world empty, and std::logic_error while live FDS_Entity objects exist,
+		since snapshots cannot bring them back.
+	*/
+	void loadSnapshot(FDS_SnapshotReader& in)
+	{
+		if (std::any_of(m_entities.begin(), m_entities.end(), [](const FDS_EntityPtr& e) { return e->isActive(); }))
+		{
+			throw std::logic_error("FDS_EntityManager::loadSnapshot: the world still holds FDS_Entity objects");
+		}
+		if (in.read<std::uint32_t>() != SNAPSHOT_MAGIC) throw std::runtime_error("FDS_EntityManager: not a world snapshot");
+		if (in.read<std::uint32_t>() != SNAPSHOT_VERSION) throw std::runtime_error("FDS_EntityManager: unsupported snapshot version");
+
+		clearWorld();
+		try
+		{
+			m_tick = in.read<std::uint32_t>();
+			const std::uint32_t records = in.read<std::uint32_t>();
+			const std::uint32_t freeCount = in.read<std::uint32_t>();
+			const std::uint32_t archetypes = in.read<std::uint32_t>();
+			const std::uint32_t pools = in.read<std::uint32_t>();
+
+			// Counts are checked against the bytes left before anything is sized by them
+			const std::byte* generations = in.take(records * sizeof(std::uint32_t));
+			if (freeCount > records) throw std::runtime_error("FDS_EntityManager: corrupt snapshot free list");
+			m_records.resize(records);
+			for (std::size_t i = 0; i < records; ++i) std::memcpy(&m_records[i].generation, generations + i * sizeof(std::uint32_t), sizeof(std::uint32_t));
+			m_freeList.resize(freeCount);
+			in.read(m_freeList.data(), freeCount * sizeof(std::uint32_t));
+			m_freeCursor.store(static_cast<std::int64_t>(m_freeList.size()), std::memory_order_relaxed);
+
+			std::vector<const FDS_ComTypeInfo*> infos;
+			std::vector<const FDS_Archetype*> loaded;
+			for (std::uint32_t a = 0; a < archetypes; ++a)
+			{
+				const std::uint32_t columns = in.read<std::uint32_t>();
+				const std::uint32_t rows = in.read<std::uint32_t>();
+
+				FDS_ComBitSet signature;
+				infos.clear();
+				for (std::uint32_t c = 0; c < columns; ++c)
+				{
+					const FDS_ComTypeInfo& info = findSnapshotType(in.read<std::uint64_t>());
+					if (signature.test(info.id)) throw std::runtime_error("FDS_EntityManager: corrupt snapshot archetype");
+					m_comInfos[info.id] = &info;
+					signature.set(info.id);
+					infos.push_back(&info);
+				}
+
+				if (rows > records) throw std::runtime_error("FDS_EntityManager: corrupt snapshot archetype");
+				FDS_Archetype& archetype = *findOrCreateArchetype(signature);
+				// Each signature is one block; a second would desync entities and columns
+				if (archetype.size() || std::find(loaded.begin(), loaded.end(), &archetype) != loaded.end())
+				{
+					throw std::runtime_error("FDS_EntityManager: corrupt snapshot archetype");
+				}
+				loaded.push_back(&archetype);
+				archetype.m_entities.resize(rows);
+				in.read(archetype.m_entities.data(), rows * sizeof(FDS_EntityID));
+				for (std::uint32_t row = 0; row < rows; ++row)
+				{
+					const FDS_EntityID id = archetype.m_entities[row];
+					if (id.index >= records || m_records[id.index].archetype || m_records[id.index].generation != id.generation)
+					{
+						throw std::runtime_error("FDS_EntityManager: corrupt snapshot entity");
+					}
+					m_records[id.index].archetype = &archetype;
+					m_records[id.index].row = row;
+				}
+				for (const FDS_ComTypeInfo* info : infos)
+				{
+					if (!info->empty) archetype.findColumn(info->id)->load(in, rows);
+				}
+			}
+
+			// Free slots must be in range, listed once and not hold an entity
+			std::vector<bool> seen(records);
+			for (std::uint32_t index : m_freeList)
+			{
+				if (index >= records || seen[index] || m_records[index].archetype) throw std::runtime_error("FDS_EntityManager: corrupt snapshot free list");
+				seen[index] = true;
+			}
+
+			for (std::uint32_t p = 0; p < pools; ++p)
+			{
+				const FDS_ComTypeInfo& info = findSnapshotType(in.read<std::uint64_t>());
+				if (info.storage != FDS_ComStorage::SparseSet) throw std::runtime_error("FDS_EntityManager: " + std::string(info.name) + " is no longer a sparse-set type");
+				const std::uint32_t count = in.read<std::uint32_t>();
+
+				// The pool indexes its sparse array by these, so each must be a distinct live entity
+				FDS_SnapshotReader peek = in;
+				const std::byte* entities = peek.take(count * sizeof(FDS_EntityID));
+				std::fill(seen.begin(), seen.end(), false);
+				for (std::uint32_t i = 0; i < count; ++i)
+				{
+					FDS_EntityID id;
+					std::memcpy(&id, entities + i * sizeof(FDS_EntityID), sizeof(FDS_EntityID));
+					if (!isAlive(id) || seen[id.index]) throw std::runtime_error("FDS_EntityManager: corrupt snapshot pool of " + std::string(info.name));
+					seen[id.index] = true;
+				}
+				getPool(info).load(in, count);
+			}
+		}
+		catch (...)
+		{
+			clearWorld();
+			throw;
+		}
+	}
+
+	// Maps the file instead of reading it, columns are copied straight out of the mapping
+	void loadSnapshot(const std::string& path)
+	{
+		FDS_MappedFile file(path);
+		FDS_SnapshotReader in(file.data(), file.size());
+		loadSnapshot(in);
+	}
+
+	// See FDS_View::eachChunk
+	template<typename... Ts, typename Func>
+	void eachChunk(Func&& func)
+	{
+		view<Ts...>().eachChunk(std::forward<Func>(func));
+	}
+
+	/*
+		pos += vel * dt for every entity holding both, through FDS_SimdAxpy.
+		Pos and Vel must be structs of the same number of floats that opt in
+		through FDS_FloatLanes. A column of them is one float stream, so rows
+		are not split into lanes and eight floats go per AVX instruction.
+		Both types live in tables, or both in sparse-set pools, which then
+		form an owning group.
+	*/
+	template<typename Pos, typename Vel>
+	void integrate(float dt)
+	{
+		static_assert(FDS_IS_FLOAT_LANES<Pos> && FDS_IS_FLOAT_LANES<Vel> && sizeof(Pos) == sizeof(Vel), "integrate needs two FDS_FloatLanes structs of the same number of floats");
+		static_assert(FDS_IS_TABLE_COM<Pos> == FDS_IS_TABLE_COM<Vel>, "integrate needs both types in tables or both in sparse-set pools");
+		constexpr std::size_t LANES = sizeof(Pos) / sizeof(float);
+
+		if constexpr (FDS_IS_TABLE_COM<Pos>)
+		{
+			eachChunk<Pos, const Vel>([dt](std::size_t count, const FDS_EntityID*, Pos* pos, const Vel* vel)
+				{
+					FDS_SimdAxpy(reinterpret_cast<float*>(pos), reinterpret_cast<const float*>(vel), dt, count * LANES);
+				});
+		}
+		else
+		{
+			const std::size_t count = group<Pos, const Vel>().size();
+			FDS_SimdAxpy(reinterpret_cast<float*>(getPool<Pos>().data()), reinterpret_cast<const float*>(getPool<Vel>().data()), dt, count * LANES);
+			touchGroup<Pos>(count);
+		}
+	}
+
+	// each() over the entities passing an FDS_Changed, FDS_Added, FDS_With or FDS_Without filter
+	template<typename... Ts, typename Filter, typename Func>
+	void each(Filter filter, Func&& func)
+	{
+		view<Ts...>().each(filter, std::forward<Func>(func));
+	}
+
+	// each() split over the manager's job system, see FDS_View::parallelEach
+	template<typename... Ts, typename Func>
+	void parallelEach(Func&& func, std::size_t minGrain = FDS_DEFAULT_GRAIN)
+	{
+		view<Ts...>().parallelEach(m_jobs, std::forward<Func>(func), minGrain);
+	}
+
+	/*
+		Owning group of the sparse-set types Ts, built on first use, see
+		FDS_OwningGroup. Throws std::logic_error if one of the pools is
+		already owned by a group of other types.
+	*/
+	template<typename... Ts>
+	FDS_OwningGroup& group()
+	{
+		static_assert(sizeof...(Ts) > 0, "A group needs at least one component type");
+		static_assert(((FDS_ComTraits<std::remove_const_t<Ts>>::storage == FDS_ComStorage::SparseSet) && ...), "Owning groups are made of sparse-set types");
+
+		FDS_ComBitSet signature;
+		(signature.set(getComTypeID<std::remove_const_t<Ts>>()), ...);
+		(getPool<std::remove_const_t<Ts>>(), ...);
+
+		FDS_OwningGroup* owner = nullptr;
+		signature.forEach([&](FDS_ComID comID)
+			{
+				FDS_OwningGroup* group = m_pools[comID]->m_group;
+				if (group && group->m_signature != signature) throw std::logic_error("FDS_EntityManager::group: " + std::string(FDS_ComRegistry::instance().find(comID)->name) + " is owned by another group");
+				owner = group;
+			});
+		if (owner) return *owner;
+
+		auto group = std::make_unique<FDS_OwningGroup>();
+		group->m_signature = signature;
+		signature.forEach([&](FDS_ComID comID)
+			{
+				group->m_pools.push_back(m_pools[comID].get());
+				m_pools[comID]->m_group = group.get();
+			});
+		group->rebuild();
+		m_owningGroups.push_back(std::move(group));
+		return *m_owningGroups.back();
+	}
+
+	/*
+		Calls func(Ts&...) or func(FDS_EntityID, Ts&...) for every entity of
+		the owning group of Ts, walking the packed arrays side by side.
+		Writable components are stamped as changed. Do not add or remove Ts
+		inside func.
+	*/
+	template<typename... Ts, typename Func>
+	void eachGroup(Func&& func)
+	{
+		const FDS_OwningGroup& owned = group<Ts...>();
+		const std::size_t size = owned.size();
+		const FDS_EntityID* entities = owned.entities();
+
+		const auto walk = [&](auto*... data)
+		{
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				if constexpr (std::is_invocable_v<Func&, FDS_EntityID, Ts&...>) func(entities[i], data[i]...);
+				else func(data[i]...);
+			}
+		};
+		walk(static_cast<Ts*>(getPool<std::remove_const_t<Ts>>().data())...);
+		(touchGroup<Ts>(size), ...);
+	}
+
+private:
+	struct FDS_System
+	{
+		std::string name;
+		FDS_SystemAccess access;
+		std::function<void(FDS_EntityManager&)> func;
+		std::vector<std::size_t> dependents;
+		std::size_t dependencies = 0;
+	};
+
+	/*
+		Brings every cached view up to date while no system runs, so
+		concurrent systems sharing one only read it
+	*/
+	void refreshViews()
+	{
+		std::unique_lock<std::shared_mutex> lock(m_viewMutex);
+		for (auto& entry : m_views) entry.second->refresh();
+	}
+
+	void runSystem(FDS_System& system)
+	{
+		FDS_Profiler::Scope scope(m_profiler.get(), system.name);
+		system.func(*this);
+	}
+
+	/*
+		FDS_Entity pass of update() timing each component call, so every
+		ungrouped FDS_Component type gets one sample: its total time, calls
+		and allocations. The samples are laid end to end inside the pass.
+	*/
+	void profileEntityUpdate(FDS_Profiler& profiler)
+	{
+		struct Total
+		{
+			std::int64_t duration = 0;
+			std::uint64_t calls = 0;
+			std::uint64_t allocations = 0;
+		};
+		std::vector<Total> totals(FDS_MAX_COM);
+		FDS_ComBitSet ran;
+
+		std::int64_t start = 0;
+		{
+			FDS_Profiler::Scope scope(&profiler, "FDS_Entity::update");
+			const std::size_t count = m_entities.size();
+			FDS_Profiler::addEntities(count);
+			start = FDS_ProfileNow();
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				FDS_Entity& e = *m_entities[i];
+				for (std::size_t c = 0; c < e.m_components.size(); ++c)
+				{
+					const FDS_ComID comID = e.m_comIDs[c];
+					if (!e.m_components[c] || isComponentGrouped(comID)) continue;
+
+					const std::uint64_t allocations = FDS_AllocationCount();
+					const std::int64_t begin = FDS_ProfileNow();
+					e.m_components[c]->update();
+					Total& total = totals[comID];
+					total.duration += FDS_ProfileNow() - begin;
+					total.allocations += FDS_AllocationCount() - allocations;
+					++total.calls;
+					ran.set(comID);
+				}
+			}
+		}
+
+		ran.forEach([&](FDS_ComID comID)
+			{
+				const Total& total = totals[comID];
+				profiler.record(profiler.scope(FDS_ComRegistry::instance().find(comID)->name), start, total.duration, total.calls, total.allocations);
+				start += total.duration;
+			});
+	}
+
+	// A system depends on every earlier system it conflicts with
+	void buildSystemGraph()
+	{
+		for (auto& system : m_systems)
+		{
+			system.dependents.clear();
+			system.dependencies = 0;
+		}
+
+		for (std::size_t later = 0; later < m_systems.size(); ++later)
+		{
+			for (std::size_t earlier = 0; earlier < later; ++earlier)
+			{
+				if (!m_systems[earlier].access.conflicts(m_systems[later].access)) continue;
+				m_systems[earlier].dependents.push_back(later);
+				++m_systems[later].dependencies;
+			}
+		}
+		m_systemGraphDirty = false;
+	}
+
+	static FDS_PoolStats makePoolStats(std::string_view name, const FDS_PoolAllocator& allocator) noexcept
+	{
+		return { name, allocator.getBlockSize(), allocator.getCapacity(), allocator.getUsed(), allocator.getPageCount(), allocator.getAllocationCount() };
+	}
+
+	static std::uint64_t nextSerial() noexcept
+	{
+		static std::atomic<std::uint64_t> serial{ 0 };
+		return ++serial;
+	}
+
+	// Brings the entities handed out by reserveEntity() to life in the root archetype
+	void flushReserved()
+	{
+		const std::int64_t cursor = m_freeCursor.load(std::memory_order_relaxed);
+		if (cursor == static_cast<std::int64_t>(m_freeList.size())) return;
+
+		const std::size_t reused = cursor > 0 ? static_cast<std::size_t>(cursor) : 0;
+		for (std::size_t i = reused; i < m_freeList.size(); ++i) spawn(m_freeList[i]);
+		m_freeList.resize(reused);
+
+		if (cursor < 0)
+		{
+			const std::size_t first = m_records.size();
+			m_records.resize(first + static_cast<std::size_t>(-cursor));
+			for (std::size_t index = first; index < m_records.size(); ++index) spawn(static_cast<std::uint32_t>(index));
+		}
+		m_freeCursor.store(static_cast<std::int64_t>(m_freeList.size()), std::memory_order_relaxed);
+	}
+
+	FDS_EntityID spawn(std::uint32_t index)
+	{
+		return spawn(index, *m_archetypes.front());
+	}
+
+	// Appends the slot's entity to archetype, whose columns the caller has already filled
+	FDS_EntityID spawn(std::uint32_t index, FDS_Archetype& archetype)
+	{
+		const FDS_EntityID id{ index, m_records[index].generation };
+		FDS_EntityRecord& record = m_records[index];
+		archetype.m_entities.push_back(id);
+		record.archetype = &archetype;
+		record.row = static_cast<std::uint32_t>(archetype.size() - 1);
+		++m_structure;
+		return id;
+	}
+
+	// Takes count slots, free ones first, and appends their entities to archetype
+	std::vector<FDS_EntityID> spawnMany(FDS_Archetype& archetype, std::size_t count)
+	{
+		std::vector<FDS_EntityID> ids;
+		ids.reserve(count);
+		archetype.m_entities.reserve(archetype.size() + count);
+
+		const std::size_t reused = std::min(count, m_freeList.size());
+		for (std::size_t i = 0; i < reused; ++i) ids.push_back(spawn(m_freeList[m_freeList.size() - 1 - i], archetype));
+		m_freeList.resize(m_freeList.size() - reused);
+
+		const std::size_t first = m_records.size();
+		m_records.resize(first + count - reused);
+		for (std::size_t index = first; index < m_records.size(); ++index) ids.push_back(spawn(static_cast<std::uint32_t>(index), archetype));
+
+		m_freeCursor.store(static_cast<std::int64_t>(m_freeList.size()), std::memory_order_relaxed);
+		return ids;
+	}
+
+	// Appends to every column of archetype, on failure all of them are cut back
+	template<typename Fill>
+	static void fillColumns(FDS_Archetype& archetype, Fill&& fill)
+	{
+		const std::size_t size = archetype.size();
+		try
+		{
+			for (FDS_Column& col : archetype.m_columns) fill(col);
+		}
+		catch (...)
+		{
+			for (FDS_Column& col : archetype.m_columns) col.truncate(size);
+			throw;
+		}
+	}
+
+	template<typename T>
+	void addTableBit(FDS_ComBitSet& signature)
+	{
+		if constexpr (FDS_IS_TABLE_COM<T>)
+		{
+			m_comInfos[getComTypeID<T>()] = &getComTypeInfo<T>();
+			signature.set(getComTypeID<T>());
+		}
+	}
+
+	template<typename T>
+	void emplacePooled(const std::vector<FDS_EntityID>& ids, const T& prototype)
+	{
+		if constexpr (!FDS_IS_TABLE_COM<T>) getPool<T>().emplaceMany(ids.data(), ids.size(), prototype);
+	}
+
+	FDS_ComSignals& getSignals(FDS_ComID comID)
+	{
+		auto& signals = m_signals[comID];
+		if (!signals)
+		{
+			signals = std::make_unique<FDS_ComSignals>();
+			m_observed.set(comID);
+		}
+		return *signals;
+	}
+
+	void queueConstruct(FDS_ComID comID, FDS_EntityID id)
+	{
+		if (!m_observed.test(comID) || m_signals[comID]->construct.empty()) return;
+		m_signals[comID]->m_constructed.push_back(id);
+		m_pendingSignals.set(comID);
+	}
+
+	void queueConstruct(FDS_ComID comID, const std::vector<FDS_EntityID>& ids)
+	{
+		if (!m_observed.test(comID) || m_signals[comID]->construct.empty() || ids.empty()) return;
+		auto& constructed = m_signals[comID]->m_constructed;
+		constructed.insert(constructed.end(), ids.begin(), ids.end());
+		m_pendingSignals.set(comID);
+	}
+
+	void queueDestroy(FDS_ComID comID, FDS_EntityID id)
+	{
+		if (!m_observed.test(comID) || m_signals[comID]->destroy.empty()) return;
+		m_signals[comID]->m_destroyed.push_back(id);
+		m_pendingSignals.set(comID);
+	}
+
+	/*
+		A replaced component is reported destroyed, then constructed. Batches
+		deliver constructs first, so the destroy goes out before the
+		construct is queued.
+	*/
+	void queueReplace(FDS_ComID comID, FDS_EntityID id)
+	{
+		queueDestroy(comID, id);
+		if (m_pendingSignals.test(comID)) flushEvents();
+		queueConstruct(comID, id);
+	}
+
+	// Finds this tick's writes through the change ticks, skipping untouched chunks
+	void emitUpdates()
+	{
+		m_observed.forEach([&](FDS_ComID comID)
+			{
+				FDS_ComSignals& signals = *m_signals[comID];
+				if (signals.update.empty()) return;
+
+				std::vector<FDS_EntityID> batch;
+				const auto collect = [&](const FDS_TickArray& ticks, const FDS_EntityID* entities)
+				{
+					for (std::size_t begin = 0; begin < ticks.size(); begin += FDS_TickArray::CHUNK)
+					{
+						if (ticks.chunk(begin / FDS_TickArray::CHUNK).changed != m_tick) continue;
+						for (std::size_t i = begin, end = std::min(begin + FDS_TickArray::CHUNK, ticks.size()); i < end; ++i)
+						{
+							if (ticks[i].changed == m_tick && ticks[i].added != m_tick) batch.push_back(entities[i]);
+						}
+					}
+				};
+
+				if (m_pools[comID])
+				{
+					collect(m_pools[comID]->ticks(), m_pools[comID]->entities().data());
+				}
+				for (const auto& archetype : m_archetypes)
+				{
+					if (FDS_Column* col = archetype->findColumn(comID)) collect(col->ticks(), archetype->m_entities.data());
+				}
+				if (!batch.empty()) signals.update.emit(batch);
+			});
+	}
+
+	static constexpr std::uint32_t SNAPSHOT_MAGIC = 0x57534446;        // "FDSW"
+	static constexpr std::uint32_t SNAPSHOT_VERSION = 2;
+
+	static const FDS_ComTypeInfo& findSnapshotType(std::uint64_t hash)
+	{
+		const FDS_ComTypeInfo* info = FDS_ComRegistry::instance().findByHash(hash);
+		if (!info) throw std::runtime_error("FDS_EntityManager: snapshot holds a component type that is not registered");
+		return *info;
+	}
+
+	// Destroys every entity, keeping archetypes, pools and their memory
+	void clearWorld() noexcept
+	{
+		for (FDS_ComGroup& group : m_groups) group.components.clear();
+		m_groupAdds.clear();
+		m_entities.clear();
+		for (const auto& archetype : m_archetypes)
+		{
+			for (FDS_Column& col : archetype->m_columns) col.clear();
+			archetype->m_entities.clear();
+		}
+		m_poolMask.forEach([&](FDS_ComID comID) { m_pools[comID]->clear(); });
+		m_records.clear();
+		m_freeList.clear();
+		m_freeCursor.store(0, std::memory_order_relaxed);
+		m_pendingDestroy.store(0, std::memory_order_relaxed);
+		m_hierarchyDirty = true;
+		++m_structure;
+	}
+
+	// Calls func(info, entity, component) for every data component written at or after tick since
+	template<typename Func>
+	void eachWrittenSince(std::uint32_t since, Func&& func)
+	{
+		const auto visit = [since](const FDS_TickArray& ticks, auto&& row)
+		{
+			for (std::size_t begin = 0; begin < ticks.size(); begin += FDS_TickArray::CHUNK)
+			{
+				if (ticks.chunk(begin / FDS_TickArray::CHUNK).changed < since) continue;
+				for (std::size_t i = begin, end = std::min(begin + FDS_TickArray::CHUNK, ticks.size()); i < end; ++i)
+				{
+					if (ticks[i].changed >= since) row(i);
+				}
+			}
+		};
+
+		for (const auto& archetype : m_archetypes)
+		{
+			for (FDS_Column& col : archetype->m_columns)
+			{
+				visit(col.ticks(), [&](std::size_t row) { func(col.info(), archetype->m_entities[row], col.get(row)); });
+			}
+		}
+		m_poolMask.forEach([&](FDS_ComID comID)
+			{
+				FDS_ComPoolBase& pool = *m_pools[comID];
+				const FDS_ComTypeInfo& info = *FDS_ComRegistry::instance().find(comID);
+				visit(pool.ticks(), [&](std::size_t slot) { func(info, pool.m_entities[slot], pool.address(slot)); });
+			});
+	}
+
+	// The entity's data component of type comID, nullptr if it has none
+	void* findComponent(FDS_ComID comID, FDS_EntityID id) noexcept
+	{
+		if (!isAlive(id)) return nullptr;
+		if (m_pools[comID]) return m_pools[comID]->contains(id) ? m_pools[comID]->address(m_pools[comID]->find(id)) : nullptr;
+
+		const FDS_EntityRecord& record = m_records[id.index];
+		FDS_Column* col = record.archetype->findColumn(comID);
+		return col ? col->get(record.row) : nullptr;
+	}
+
+	template<typename T>
+	void touchGroup(std::size_t size)
+	{
+		if constexpr (!std::is_const_v<T>) m_pools[getComTypeID<T>()]->m_ticks.touch(0, size, m_tick);
+	}
+
+	// addComponent without the FDS_Parent checks
+	template<typename T, typename... TArgs>
+	T& emplaceComponent(FDS_EntityID id, TArgs&&... mArgs)
+	{
+		flushReserved();
+		if (!isAlive(id)) throw std::invalid_argument("FDS_EntityManager::addComponent: dead entity");
+		if (hasComponent<T>(id))
+		{
+			T& com = getComponent<T>(id);
+			if constexpr (!FDS_IS_TAG_COM<T>)
+			{
+				com = T(std::forward<TArgs>(mArgs)...);
+				queueReplace(getComTypeID<T>(), id);
+			}
+			return com;
+		}
+
+		queueConstruct(getComTypeID<T>(), id);
+		if constexpr (FDS_ComTraits<T>::storage == FDS_ComStorage::SparseSet)
+		{
+			++m_structure;
+			return getPool<T>().emplace(id, std::forward<TArgs>(mArgs)...);
+		}
+		else
+		{
+			T com(std::forward<TArgs>(mArgs)...);
+			FDS_EntityRecord& record = m_records[id.index];
+			FDS_Archetype* dst = addEdge(*record.archetype, getComTypeInfo<T>());
+			moveEntity(id, *dst);
+			if constexpr (FDS_IS_TAG_COM<T>) return FDS_TagInstance<T>();
+			else return dst->findColumn(getComTypeID<T>())->template emplace<T>(std::move(com));
+		}
+	}
+
+	// Restored values of FDS_Parent may relink the hierarchy
+	void touchComponent(FDS_ComID comID, FDS_EntityID id)
+	{
+		if (comID == getComTypeID<FDS_Parent>()) m_hierarchyDirty = true;
+		if (m_pools[comID])
+		{
+			m_pools[comID]->touch(id, m_tick);
+		}
+		else
+		{
+			const FDS_EntityRecord& record = m_records[id.index];
+			record.archetype->findColumn(comID)->ticks().touch(record.row, m_tick);
+		}
+	}
+
+	template<typename Local, typename World, typename Func>
+	void propagateRange(Func& func, std::vector<World*>& worlds, std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; ++i)
+		{
+			const FDS_Hierarchy::Node& node = m_hierarchy.m_nodes[i];
+			if (!hasComponent<Local>(node.entity) || !hasComponent<World>(node.entity)) continue;
+
+			World& world = getComponent<World>(node.entity);
+			func(getComponent<const Local>(node.entity), node.parent == FDS_Hierarchy::NO_PARENT ? nullptr : worlds[node.parent], world);
+			worlds[i] = &world;
+		}
+	}
+
+	// Breadth-first from the roots over the links sorted by parent
+	void buildHierarchy()
+	{
+		struct Link
+		{
+			FDS_EntityID parent;
+			FDS_EntityID child;
+		};
+		std::vector<Link> links;
+		std::vector<FDS_EntityID> roots;
+		each<const FDS_Parent>([&](FDS_EntityID id, const FDS_Parent& parent)
+			{
+				if (isAlive(parent.entity)) links.push_back({ parent.entity, id });
+				else roots.push_back(id);
+			});
+
+		const auto byParent = [](const Link& a, const Link& b) { return a.parent.index < b.parent.index; };
+		std::sort(links.begin(), links.end(), byParent);
+		for (std::size_t i = 0; i < links.size(); ++i)
+		{
+			const FDS_EntityID parent = links[i].parent;
+			if ((i == 0 || links[i - 1].parent != parent) && !hasComponent<FDS_Parent>(parent)) roots.push_back(parent);
+		}
+
+		std::vector<FDS_Hierarchy::Node>& nodes = m_hierarchy.m_nodes;
+		std::vector<std::size_t>& levels = m_hierarchy.m_levels;
+		nodes.clear();
+		levels.clear();
+		for (FDS_EntityID root : roots) nodes.push_back({ root, FDS_Hierarchy::NO_PARENT, 0, 0 });
+
+		for (std::size_t begin = 0, end = nodes.size(); begin < end; begin = end, end = nodes.size())
+		{
+			levels.push_back(begin);
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				const auto range = std::equal_range(links.begin(), links.end(), Link{ nodes[i].entity, FDS_NULL_ENTITY }, byParent);
+				nodes[i].firstChild = static_cast<std::uint32_t>(nodes.size());
+				nodes[i].childCount = static_cast<std::uint32_t>(range.second - range.first);
+				for (auto it = range.first; it != range.second; ++it) nodes.push_back({ it->child, static_cast<std::uint32_t>(i), 0, 0 });
+			}
+		}
+		levels.push_back(nodes.size());
+		m_hierarchyDirty = false;
+	}
+
+	// Joins after the running pass, whose group loop holds the array
+	void addToGroup(FDS_ComID comID, FDS_Component* com)
+	{
+		if (m_comPasses)
+		{
+			m_groupAdds.push_back({ comID, com });
+			return;
+		}
+		for (FDS_ComGroup& group : m_groups)
+		{
+			if (group.id == comID) group.components.push_back(com);
+		}
+	}
+
+	// Swaps old for com in comID's group, or drops it when com is nullptr, leaving a hole during a pass
+	void replaceInGroup(FDS_ComID comID, const FDS_Component* old, FDS_Component* com)
+	{
+		for (auto& added : m_groupAdds)
+		{
+			if (added.second == old) added.second = com;
+		}
+		for (FDS_ComGroup& group : m_groups)
+		{
+			if (group.id != comID) continue;
+			const auto it = std::find(group.components.begin(), group.components.end(), old);
+			if (it == group.components.end()) continue;
+			if (com) *it = com;
+			else if (m_comPasses) *it = nullptr;
+			else group.components.erase(it);
+		}
+	}
+
+	/*
+		Marks an update() or draw() pass over legacy components; when the
+		outermost one ends, removed and replaced components are freed and
+		the groups compacted.
+	*/
+	struct ComponentPass
+	{
+		explicit ComponentPass(FDS_EntityManager& manager) noexcept : manager(manager) { ++manager.m_comPasses; }
+		~ComponentPass() { if (--manager.m_comPasses == 0) manager.sweepComponents(); }
+
+		FDS_EntityManager& manager;
+	};
+
+	void sweepComponents()
+	{
+		for (auto& e : m_entities)
+		{
+			if (!e->m_retired.empty() && !e->m_passes) e->sweep();
+		}
+		for (FDS_ComGroup& group : m_groups)
+		{
+			group.components.erase(std::remove(group.components.begin(), group.components.end(), nullptr), group.components.end());
+		}
+		for (const auto& added : m_groupAdds)
+		{
+			if (added.second) addToGroup(added.first, added.second);
+		}
+		m_groupAdds.clear();
+	}
+
+	// Frees a slot whose row is already gone, its FDS_Entity goes with the next refresh()
+	void release(std::uint32_t index)
+	{
+		FDS_EntityRecord& record = m_records[index];
+		if (record.entity) record.entity->destroy();
+		record.archetype = nullptr;
+		record.entity = nullptr;
+		++record.generation;
+		m_freeList.push_back(index);
+		++m_structure;
+		if (m_hierarchy.size()) m_hierarchyDirty = true;
+	}
+
+	FDS_ComPoolBase& getPool(const FDS_ComTypeInfo& info)
+	{
+		auto& pool = m_pools[info.id];
+		if (!pool)
+		{
+			pool = info.createPool();
+			pool->setClock(&m_tick);
+			m_poolMask.set(info.id);
+		}
+		return *pool;
+	}
+
+	struct FDS_EntityRecord
+	{
+		FDS_Archetype* archetype = nullptr;
+		FDS_Entity* entity = nullptr;
+		std::uint32_t row = 0;
+		std::uint32_t generation = 0;
+	};
+
+	FDS_Archetype* findOrCreateArchetype(const FDS_ComBitSet& signature)
+	{
+		auto it = m_archetypeMap.find(signature);
+		if (it != m_archetypeMap.end()) return it->second;
+
+		std::vector<const FDS_ComTypeInfo*> infos;
+		signature.forEach([&](FDS_ComID id) { infos.push_back(m_comInfos[id]); });
+
+		m_archetypes.emplace_back(std::make_unique<FDS_Archetype>(signature, infos, &m_tick));
+		FDS_Archetype* archetype = m_archetypes.back().get();
+		m_archetypeMap.emplace(signature, archetype);
+		return archetype;
+	}
+
+	FDS_Archetype* addEdge(FDS_Archetype& src, const FDS_ComTypeInfo& info)
+	{
+		auto it = src.m_addEdges.find(info.id);
+		if (it != src.m_addEdges.end()) return it->second;
+
+		m_comInfos[info.id] = &info;
+		FDS_Archetype* dst = findOrCreateArchetype(FDS_ComBitSet(src.m_signature).set(info.id));
+		src.m_addEdges.emplace(info.id, dst);
+		dst->m_removeEdges.emplace(info.id, &src);
+		return dst;
+	}
+
+	FDS_Archetype* removeEdge(FDS_Archetype& src, FDS_ComID id)
+	{
+		auto it = src.m_removeEdges.find(id);
+		if (it != src.m_removeEdges.end()) return it->second;
+
+		FDS_Archetype* dst = findOrCreateArchetype(FDS_ComBitSet(src.m_signature).reset(id));
+		src.m_removeEdges.emplace(id, dst);
+		dst->m_addEdges.emplace(id, &src);
+		return dst;
+	}
+
+	// Moves the entity's shared columns into dst, the caller fills any column dst has in addition
+	void moveEntity(FDS_EntityID id, FDS_Archetype& dst)
+	{
+		FDS_EntityRecord& record = m_records[id.index];
+		FDS_Archetype& src = *record.archetype;
+
+		for (FDS_Column& col : src.m_columns)
+		{
+			if (FDS_Column* target = dst.findColumn(col.info().id)) target->pushFrom(col, record.row);
+			col.swapRemove(record.row);
+		}
+		removeRow(src, record.row);
+
+		dst.m_entities.push_back(id);
+		record.archetype = &dst;
+		record.row = static_cast<std::uint32_t>(dst.size() - 1);
+		++m_structure;
+	}
+
+	/*
+		Moves every entity of ids, which are live and distinct, to the archetype
+		dstOf returns for its current one. Each column of a source archetype is
+		copied in one call, runs of adjacent rows as single blocks, and the rows
+		are then swap-removed from the back so none still to go is moved;
+		fill(dst, count) appends the columns only dst has.
+	*/
+	template<typename DstOf, typename Fill>
+	void migrateMany(const std::vector<FDS_EntityID>& ids, DstOf&& dstOf, Fill&& fill)
+	{
+		// Moved rows of each source archetype as a bitmap
+		std::vector<std::pair<FDS_Archetype*, std::vector<std::uint64_t>>> sources;
+		for (FDS_EntityID id : ids)
+		{
+			const FDS_EntityRecord& record = m_records[id.index];
+			if (sources.empty() || sources.back().first != record.archetype)
+			{
+				auto it = std::find_if(sources.begin(), sources.end(), [&](const auto& source) { return source.first == record.archetype; });
+				if (it == sources.end())
+				{
+					sources.emplace_back(record.archetype, std::vector<std::uint64_t>((record.archetype->size() + 63) / 64));
+				}
+				else
+				{
+					std::iter_swap(it, sources.end() - 1);
+				}
+			}
+			sources.back().second[record.row / 64] |= std::uint64_t(1) << (record.row % 64);
+		}
+
+		std::vector<std::uint32_t> rows;
+		std::vector<FDS_EntityID> moved;
+		for (auto& [archetype, bits] : sources)
+		{
+			FDS_Archetype& src = *archetype;
+			FDS_Archetype& dst = *dstOf(src);
+
+			rows.clear();
+			for (std::size_t word = 0; word < bits.size(); ++word)
+			{
+				for (std::uint64_t w = bits[word]; w; w &= w - 1) rows.push_back(static_cast<std::uint32_t>(word * 64 + FDS_CountTrailingZeros(w)));
+			}
+			const std::size_t count = rows.size();
+
+			// Rows that already are the last ones are cut off together, e.g. when the whole archetype moves
+			std::size_t tail = 0;
+			while (tail < count && rows[count - 1 - tail] == src.size() - 1 - tail) ++tail;
+
+			for (FDS_Column& col : src.m_columns)
+			{
+				if (FDS_Column* target = dst.findColumn(col.info().id)) target->pushRows(col, rows.data(), count);
+				col.truncate(src.size() - tail);
+				for (std::size_t i = count - tail; i-- > 0;) col.swapRemove(rows[i]);
+			}
+			fill(dst, count);
+
+			moved.clear();
+			for (std::uint32_t row : rows) moved.push_back(src.m_entities[row]);
+			for (std::size_t i = count; i-- > 0;) removeRow(src, rows[i]);
+
+			dst.m_entities.reserve(dst.size() + count);
+			for (FDS_EntityID id : moved)
+			{
+				dst.m_entities.push_back(id);
+				m_records[id.index].archetype = &dst;
+				m_records[id.index].row = static_cast<std::uint32_t>(dst.size() - 1);
+			}
+		}
+		++m_structure;
+	}
+
+	// Drops stale and repeated handles, keeping the order of the rest
+	void uniqueAlive(std::vector<FDS_EntityID>& ids) const
+	{
+		std::vector<std::uint64_t> seen((m_records.size() + 63) / 64);
+		ids.erase(std::remove_if(ids.begin(), ids.end(), [&](FDS_EntityID id)
+			{
+				if (!isAlive(id)) return true;
+				std::uint64_t& word = seen[id.index / 64];
+				const std::uint64_t bit = std::uint64_t(1) << (id.index % 64);
+				if (word & bit) return true;
+				word |= bit;
+				return false;
+			}), ids.end());
+	}
+
+	void removeRow(FDS_Archetype& archetype, std::uint32_t row) noexcept
+	{
+		const FDS_EntityID last = archetype.m_entities.back();
+		archetype.m_entities[row] = last;
+		archetype.m_entities.pop_back();
+		m_records[last.index].row = row;
+	}
+
+private:
+	std::vector<FDS_EntityRecord> m_records;
+	std::vector<std::uint32_t> m_freeList;
+	std::atomic<std::int64_t> m_freeCursor{ 0 };
+	std::vector<std::unique_ptr<FDS_Archetype>> m_archetypes;
+	std::unordered_map<FDS_ComBitSet, FDS_Archetype*> m_archetypeMap;
+	std::uint32_t m_tick = 1;
+	std::uint64_t m_structure = 0;   // bumped by every entity or component set change
+	std::array<const FDS_ComTypeInfo*, FDS_MAX_COM> m_comInfos = {};
+	std::array<std::unique_ptr<FDS_ComPoolBase>, FDS_MAX_COM> m_pools = {};
+	FDS_ComBitSet m_poolMask;
+	std::unordered_map<std::type_index, std::unique_ptr<FDS_ViewBase>> m_views;
+	std::shared_mutex m_viewMutex;
+	std::vector<FDS_System> m_systems;
+	bool m_systemGraphDirty = false;
+	FDS_JobSystem* m_jobs = nullptr;
+	const std::uint64_t m_serial;
+	std::mutex m_commandMutex;
+	std::vector<std::unique_ptr<FDS_CommandBuffer>> m_commandBuffers;
+	std::atomic<std::size_t> m_pendingDestroy{ 0 };
+	std::array<std::unique_ptr<FDS_ComSignals>, FDS_MAX_COM> m_signals = {};
+	FDS_ComBitSet m_observed;
+	FDS_ComBitSet m_pendingSignals;
+	std::vector<FDS_ComGroup> m_groups;
+	FDS_ComBitSet m_grouped;
+	std::uint32_t m_comPasses = 0;
+	std::vector<std::pair<FDS_ComID, FDS_Component*>> m_groupAdds;
+	FDS_Hierarchy m_hierarchy;
+	bool m_hierarchyDirty = false;
+	std::vector<std::unique_ptr<FDS_OwningGroup>> m_owningGroups;
+	std::array<FDS_ResourcePtr, FDS_MAX_RESOURCE> m_resources;
+	std::unique_ptr<FDS_Profiler> m_profiler;
+	FDS_PoolAllocator m_entityAllocator{ sizeof(FDS_Entity), alignof(FDS_Entity) };
+	std::array<std::unique_ptr<FDS_PoolAllocator>, FDS_MAX_COM> m_comAllocators = {};
+	FDS_Arena m_arena;
+	std::vector<FDS_EntityPtr> m_entities;
+};
+
+// Binds one component type of a view to the storage it lives in
+template<typename T, bool Table = FDS_IS_TABLE_COM<T>>
+class FDS_ViewAccess
+{
+public:
+	explicit FDS_ViewAccess(FDS_EntityManager& manager) noexcept : m_tick(manager.getTick()) {}
+
+	void bind(FDS_Archetype& archetype)
+	{
+		if constexpr (!FDS_IS_TAG_COM<T>)
+		{
+			FDS_Column* col = archetype.findColumn(getComTypeID<std::remove_const_t<T>>());
+			m_column = col->data<std::remove_const_t<T>>();
+			m_ticks = &col->ticks();
+		}
+	}
+
+	bool contains(FDS_EntityID) const noexcept { return true; }
+
+	T& get(std::size_t row, FDS_EntityID) const noexcept
+	{
+		if constexpr (FDS_IS_TAG_COM<T>) return FDS_TagInstance<std::remove_const_t<T>>();
+		else return m_column[row];
+	}
+
+	// Stamps a visited row as written unless T is read-only
+	void touch(std::size_t row, FDS_EntityID) const noexcept
+	{
+		if constexpr (!std::is_const_v<T> && !FDS_IS_TAG_COM<T>) m_ticks->touch(row, m_tick);
+	}
+
+private:
+	std::remove_const_t<T>* m_column = nullptr;
+	FDS_TickArray* m_ticks = nullptr;
+	std::uint32_t m_tick;
+};
+
+template<typename T>
+class FDS_ViewAccess<T, false>
+{
+public:
+	explicit FDS_ViewAccess(FDS_EntityManager& manager) : m_pool(&manager.getPool<std::remove_const_t<T>>()), m_tick(manager.getTick()) {}
+
+	void bind(FDS_Archetype&) noexcept {}
+	bool contains(FDS_EntityID id) const noexcept { return m_pool->contains(id); }
+	T& get(std::size_t, FDS_EntityID id) const noexcept { return m_pool->get(id); }
+	const FDS_ComPoolBase& pool() const noexcept { return *m_pool; }
+
+	void touch(std::size_t, FDS_EntityID id) const noexcept
+	{
+		if constexpr (!std::is_const_v<T>) m_pool->touch(id, m_tick);
+	}
+
+private:
+	FDS_ComPool<std::remove_const_t<T>>* m_pool;
+	std::uint32_t m_tick;
+};
+
+/*
+	Matches archetype signatures against the table components of Ts once and
+	caches the result. Archetypes are only ever appended, so refreshing only
+	checks the ones created since the last call, and iteration cost scales with
+	the matched entities rather than every entity in the manager.
+	Sparse-set components are tested per matched entity, or, when all of Ts are
+	sparse-set, the loop is driven by the smallest pool.
+*/
+template<typename... Ts>
+class FDS_View : public FDS_ViewBase
+{
+public:
+	static_assert(sizeof...(Ts) > 0, "FDS_View needs at least one component type");
+
+	// Sparse-set pools are created here so iterating never mutates the manager
+	explicit FDS_View(FDS_EntityManager& manager) : m_manager(&manager)
+	{
+		(setRequired<Ts>(), ...);
+	}
+
+	template<typename Func>
+	void each(Func&& func)
+	{
+		for (const Range& range : getRanges())
+		{
+			FDS_Profiler::addEntities(range.end - range.begin);
+			eachRange(func, range, AnyRow(), std::index_sequence_for<Ts...>{});
+		}
+	}
+
+	/*
+		Calls func(count, entities, Ts*...) once per non-empty matched archetype
+		with pointers to its columns, leaving the row loop to the caller so it
+		can be inlined and vectorized. All rows of a non-const T are marked
+		changed, tags are passed as nullptr. Only for views whose Ts are all
+		table components.
+	*/
+	template<typename Func>
+	void eachChunk(Func&& func)
+	{
+		static_assert((FDS_IS_TABLE_COM<Ts> && ...), "eachChunk needs table components");
+
+		refresh();
+		const std::uint32_t tick = m_manager->getTick();
+		for (FDS_Archetype* archetype : m_archetypes)
+		{
+			const std::size_t count = archetype->size();
+			if (!count) continue;
+
+			FDS_Profiler::addEntities(count);
+			func(count, archetype->entities().data(), static_cast<Ts*>(archetype->column<std::remove_const_t<Ts>>())...);
+			(touchColumn<Ts>(*archetype, count, tick), ...);
+		}
+	}
+
+	/*
+		each() restricted to entities whose T was written (FDS_Changed) or
+		added (FDS_Added) at or after filter.since. Chunks of rows nothing
+		touched since then are skipped without reading their rows, so the
+		cost follows the changes.
+	*/
+	template<typename T, typename Func>
+	void each(FDS_Changed<T> filter, Func&& func)
+	{
+		eachSince<T>(filter.since, &FDS_ComTicks::changed, func);
+	}
+
+	template<typename T, typename Func>
+	void each(FDS_Added<T> filter, Func&& func)
+	{
+		eachSince<T>(filter.since, &FDS_ComTicks::added, func);
+	}
+
+	// each() restricted by the presence of other components, e.g. tags; table types are settled per archetype
+	template<typename... Us, typename Func>
+	void each(FDS_With<Us...>, Func&& func)
+	{
+		eachPresence<true, Us...>(func);
+	}
+
+	template<typename... Us, typename Func>
+	void each(FDS_Without<Us...>, Func&& func)
+	{
+		eachPresence<false, Us...>(func);
+	}
+
+	/*
+		Splits the matched entities into chunks of at least minGrain rows and runs
+		func on them concurrently, so func must be safe to call from several threads.
+		Chunk boundaries are multiples of FDS_CACHE_LINE rows, so no two chunks
+		share a cache line of any column. Queries with no more than minGrain
+		matches, or without a job system, run on the calling thread.
+	*/
+	template<typename Func>
+	void parallelEach(FDS_JobSystem* jobs, Func&& func, std::size_t minGrain = FDS_DEFAULT_GRAIN)
+	{
+		const std::vector<Range> ranges = getRanges();
+		std::size_t total = 0;
+		for (const Range& range : ranges) total += range.end;
+		FDS_Profiler::addEntities(total);
+
+		if (!jobs || jobs->getThreadCount() == 0 || total <= minGrain)
+		{
+			for (const Range& range : ranges) eachRange(func, range, AnyRow(), std::index_sequence_for<Ts...>{});
+			return;
+		}
+
+		// A few chunks per thread so stealing can even out uneven rows
+		std::size_t chunk = std::max(minGrain, total / ((jobs->getThreadCount() + 1) * 4));
+		chunk = (chunk + FDS_CACHE_LINE - 1) / FDS_CACHE_LINE * FDS_CACHE_LINE;
+
+		FDS_JobCounter counter;
+		for (const Range& range : ranges)
+		{
+			for (std::size_t begin = 0; begin < range.end; begin += chunk)
+			{
+				const Range part{ range.archetype, range.entities, begin, std::min(begin + chunk, range.end) };
+				jobs->submit(counter, [this, &func, part]() { eachRange(func, part, AnyRow(), std::index_sequence_for<Ts...>{}); });
+			}
+		}
+		jobs->wait(counter);
+	}
+
+	// Archetypes currently matching the table components of Ts
+	const std::vector<FDS_Archetype*>& getArchetypes()
+	{
+		refresh();
+		return m_archetypes;
+	}
+
+private:
+	// Rows [begin, end) of an archetype, or of the smallest pool when all of Ts are sparse-set
+	struct Range
+	{
+		FDS_Archetype* archetype;
+		const std::vector<FDS_EntityID>* entities;
+		std::size_t begin;
+		std::size_t end;
+	};
+
+	template<typename T>
+	static void touchColumn(FDS_Archetype& archetype, std::size_t count, std::uint32_t tick)
+	{
+		if constexpr (!std::is_const_v<T> && !FDS_IS_TAG_COM<T>) archetype.findColumn(getComTypeID<T>())->ticks().touch(0, count, tick);
+	}
+
+	struct AnyRow
+	{
+		bool operator()(std::size_t) const noexcept { return true; }
+	};
+
+	template<typename T>
+	void setRequired()
+	{
+		if constexpr (FDS_IS_TABLE_COM<T>) m_required.set(getComTypeID<std::remove_const_t<T>>());
+		else m_manager->getPool<std::remove_const_t<T>>();
+	}
+
+	void refresh() override
+	{
+		const auto& archetypes = m_manager->getArchetypes();
+		for (; m_checked < archetypes.size(); ++m_checked)
+		{
+			FDS_Archetype* archetype = archetypes[m_checked].get();
+			if (archetype->signature().includes(m_required)) m_archetypes.push_back(archetype);
+		}
+	}
+
+	std::vector<Range> getRanges()
+	{
+		std::vector<Range> ranges;
+		if constexpr ((FDS_IS_TABLE_COM<Ts> || ...))
+		{
+			refresh();
+			ranges.reserve(m_archetypes.size());
+			for (FDS_Archetype* archetype : m_archetypes)
+			{
+				if (archetype->size()) ranges.push_back({ archetype, &archetype->entities(), 0, archetype->size() });
+			}
+		}
+		else
+		{
+			const FDS_ComPoolBase* smallest = nullptr;
+			((smallest = smallestPool<Ts>(smallest)), ...);
+			ranges.push_back({ nullptr, &smallest->entities(), 0, smallest->size() });
+		}
+		return ranges;
+	}
+
+	template<typename T>
+	const FDS_ComPoolBase* smallestPool(const FDS_ComPoolBase* smallest)
+	{
+		const FDS_ComPoolBase& pool = m_manager->getPool<std::remove_const_t<T>>();
+		return !smallest || pool.size() < smallest->size() ? &pool : smallest;
+	}
+
+	template<typename Func, typename... Cs>
+	static void invoke(Func& func, FDS_EntityID id, Cs&... coms)
+	{
+		if constexpr (std::is_invocable_v<Func&, FDS_EntityID, Cs&...>) func(id, coms...);
+		else func(coms...);
+	}
+
+	// Writable components of every visited row are stamped with the current tick
+	template<typename Func, typename Filter, std::size_t... Is>
+	void eachRange(Func& func, const Range& range, const Filter& filter, std::index_sequence<Is...>) const
+	{
+		std::tuple<FDS_ViewAccess<Ts>...> access{ FDS_ViewAccess<Ts>(*m_manager)... };
+		if (range.archetype) (std::get<Is>(access).bind(*range.archetype), ...);
+
+		const FDS_EntityID* entities = range.entities->data();
+		for (std::size_t row = range.begin; row < range.end; ++row)
+		{
+			const FDS_EntityID id = entities[row];
+			if (!filter(row) || !(std::get<Is>(access).contains(id) && ...)) continue;
+			invoke(func, id, std::get<Is>(access).get(row, id)...);
+			(std::get<Is>(access).touch(row, id), ...);
+		}
+	}
+
+	template<bool Present, typename... Us, typename Func>
+	void eachPresence(Func& func)
+	{
+		FDS_ComBitSet tables;
+		((FDS_IS_TABLE_COM<Us> ? (void)tables.set(getComTypeID<std::remove_const_t<Us>>()) : (void)0), ...);
+
+		for (const Range& range : getRanges())
+		{
+			const bool settled = range.archetype != nullptr;
+			if (settled && (Present ? !range.archetype->signature().includes(tables) : range.archetype->signature().intersects(tables))) continue;
+
+			const FDS_EntityID* entities = range.entities->data();
+			const auto filter = [&](std::size_t row)
+			{
+				const FDS_EntityID id = entities[row];
+				if constexpr (Present) return (((settled && FDS_IS_TABLE_COM<Us>) || m_manager->hasComponent<std::remove_const_t<Us>>(id)) && ...);
+				else return !(((!settled || !FDS_IS_TABLE_COM<Us>) && m_manager->hasComponent<std::remove_const_t<Us>>(id)) || ...);
+			};
+			eachRange(func, range, filter, std::index_sequence_for<Ts...>{});
+		}
+	}
+
+	template<typename T, typename Func>
+	void eachSince(std::uint32_t since, std::uint32_t FDS_ComTicks::* tick, Func& func)
+	{
+		static_assert((std::is_same_v<T, std::remove_const_t<Ts>> || ...), "The filtered type must be one of the view's components");
+		static_assert(!FDS_IS_TAG_COM<T>, "Tags have no change ticks");
+		constexpr std::size_t CHUNK = FDS_TickArray::CHUNK;
+
+		if constexpr (FDS_IS_TABLE_COM<T>)
+		{
+			for (const Range& range : getRanges())
+			{
+				const FDS_TickArray& ticks = range.archetype->findColumn(getComTypeID<T>())->ticks();
+				const auto recent = [&](std::size_t row) { return ticks[row].*tick >= since; };
+				for (std::size_t begin = range.begin, end; begin < range.end; begin = end)
+				{
+					end = std::min((begin / CHUNK + 1) * CHUNK, range.end);
+					if (ticks.chunk(begin / CHUNK).*tick < since) continue;
+					eachRange(func, { range.archetype, range.entities, begin, end }, recent, std::index_sequence_for<Ts...>{});
+				}
+			}
+		}
+		else
+		{
+			// Driven by T's pool, whose chunks are skipped the same way
+			FDS_ComPool<T>& pool = m_manager->getPool<T>();
+			const FDS_TickArray& ticks = pool.ticks();
+			for (std::size_t begin = 0; begin < pool.size(); begin += CHUNK)
+			{
+				if (ticks.chunk(begin / CHUNK).*tick < since) continue;
+				for (std::size_t i = begin, end = std::min(begin + CHUNK, pool.size()); i < end; ++i)
+				{
+					const FDS_EntityID id = pool.entities()[i];
+					if (ticks[i].*tick < since || !(m_manager->hasComponent<std::remove_const_t<Ts>>(id) && ...)) continue;
+					invoke(func, id, m_manager->getComponent<Ts>(id)...);
+				}
+			}
+		}
+	}
+
+private:
+	FDS_EntityManager* m_manager;
+	FDS_ComBitSet m_required;
+	std::vector<FDS_Archetype*> m_archetypes;
+	std::size_t m_checked = 0;
+};
+
+// Systems running in parallel may look views up concurrently, a new one is published refreshed
+template<typename... Ts>
+FDS_View<Ts...>& FDS_EntityManager::view()
+{
+	const std::type_index type(typeid(FDS_View<Ts...>));
+	{
+		std::shared_lock<std::shared_mutex> lock(m_viewMutex);
+		const auto it = m_views.find(type);
+		if (it != m_views.end()) return static_cast<FDS_View<Ts...>&>(*it->second);
+	}
+
+	std::unique_lock<std::shared_mutex> lock(m_viewMutex);
+	auto& view = m_views[type];
+	if (!view)
+	{
+		view = std::make_unique<FDS_View<Ts...>>(*this);
+		view->refresh();
+	}
+	return static_cast<FDS_View<Ts...>&>(*view);
+}
+
+// Each system owns its view so concurrently running systems never share query state
+template<typename... Ts, typename Func, typename>
+void FDS_EntityManager::addSystem(const std::string& name, Func func)
+{
+	FDS_SystemAccess access;
+	(access.access<Ts>(), ...);
+
+	auto view = std::make_shared<FDS_View<Ts...>>(*this);
+	addSystem(name, access, [view, func](FDS_EntityManager&) mutable { view->each(func); });
+}
+
+template<typename T>
+bool FDS_Entity::hasComponent() const
+{
+	if constexpr (std::is_base_of_v<FDS_Component, T>)
+	{
+		return m_comBitSet[getComTypeID<T>()];
+	}
+	else
+	{
+		return m_manager && m_manager->hasComponent<T>(m_id);
+	}
+}
+
+template<typename T, typename... TArgs>
+T& FDS_Entity::addComponent(TArgs&&... mArgs)
+{
+	if constexpr (std::is_base_of_v<FDS_Component, T>)
+	{
+		FDS_PoolAllocator* pool = m_manager ? &m_manager->getComAllocator(getComTypeInfo<T>()) : nullptr;
+		T* com = nullptr;
+		if (pool)
+		{
+			void* block = pool->allocate();
+			try
+			{
+				com = new (block) T(std::forward<TArgs>(mArgs)...);
+			}
+			catch (...)
+			{
+				pool->deallocate(block);
+				throw;
+			}
+		}
+		else
+		{
+			com = new T(std::forward<TArgs>(mArgs)...);
+		}
+		com->owner = this;
+
+		FDS_ComPtr uPtr{ com, { pool } };
+		const FDS_ComID comID = getComTypeID<T>();
+		if (m_comBitSet[comID])
+		{
+			// The new component takes the old one's slot, the old one is destroyed now or after the running pass
+			const std::size_t i = std::find(m_comIDs.begin(), m_comIDs.end(), comID) - m_comIDs.begin();
+			if (m_manager)
+			{
+				m_manager->queueReplace(comID, m_id);
+				if (m_manager->isComponentGrouped(comID)) m_manager->replaceInGroup(comID, m_components[i].get(), com);
+			}
+			if (deferRemoval()) m_retired.push_back(std::move(m_components[i]));
+			m_components[i] = std::move(uPtr);
+		}
+		else
+		{
+			m_components.emplace_back(std::move(uPtr));
+			m_comIDs.push_back(comID);
+			m_comBitSet.set(comID);
+			if (m_manager)
+			{
+				m_manager->queueConstruct(comID, m_id);
+				if (m_manager->isComponentGrouped(comID)) m_manager->addToGroup(comID, com);
+			}
+		}
+
+		com->init();
+		return *com;
+	}
+	else
+	{
+		return requireManager().addComponent<T>(m_id, std::forward<TArgs>(mArgs)...);
+	}
+}
+
+template<typename T>
+T& FDS_Entity::getComponent() const
+{
+	if constexpr (std::is_base_of_v<FDS_Component, T>)
+	{
+		const auto it = std::find(m_comIDs.begin(), m_comIDs.end(), getComTypeID<T>());
+		return *static_cast<T*>(m_components[it - m_comIDs.begin()].get());
+	}
+	else
+	{
+		return m_manager->getComponent<T>(m_id);
+	}
+}
+
+template<typename T>
+void FDS_Entity::removeComponent()
+{
+	if constexpr (std::is_base_of_v<FDS_Component, T>)
+	{
+		const FDS_ComID comID = getComTypeID<T>();
+		if (!m_comBitSet[comID]) return;
+
+		const std::size_t i = std::find(m_comIDs.begin(), m_comIDs.end(), comID) - m_comIDs.begin();
+		if (m_manager)
+		{
+			m_manager->queueDestroy(comID, m_id);
+			if (m_manager->isComponentGrouped(comID)) m_manager->replaceInGroup(comID, m_components[i].get(), nullptr);
+		}
+		m_comBitSet.reset(comID);
+		if (deferRemoval())
+		{
+			m_retired.push_back(std::move(m_components[i]));
+			m_comIDs[i] = FDS_INVALID_COM;
+			return;
+		}
+		m_components.erase(m_components.begin() + i);
+		m_comIDs.erase(m_comIDs.begin() + i);
+	}
+	else
+	{
+		if (m_manager) m_manager->removeComponent<T>(m_id);
+	}
+}
+
+inline void FDS_Entity::update()
+{
+	++m_passes;
+	try
+	{
+		for (std::size_t i = 0; i < m_components.size(); ++i)
+		{
+			FDS_Component* com = m_components[i].get();
+			if (com && (!m_manager || !m_manager->isComponentGrouped(m_comIDs[i]))) com->update();
+		}
+	}
+	catch (...)
+	{
+		endPass();
+		throw;
+	}
+	endPass();
+}
+
+inline void FDS_Entity::draw()
+{
+	++m_passes;
+	try
+	{
+		for (std::size_t i = 0; i < m_components.size(); ++i)
+		{
+			FDS_Component* com = m_components[i].get();
+			if (com && (!m_manager || !m_manager->isComponentGrouped(m_comIDs[i]))) com->draw();
+		}
+	}
+	catch (...)
+	{
+		endPass();
+		throw;
+	}
+	endPass();
+}
+
+inline bool FDS_Entity::deferRemoval() const noexcept
+{
+	return m_passes || (m_manager && m_manager->m_comPasses);
+}
+
+// The manager sweeps after its own pass
+inline void FDS_Entity::endPass()
+{
+	if (--m_passes == 0 && !m_retired.empty() && !(m_manager && m_manager->m_comPasses)) sweep();
+}
+
+inline void FDS_Entity::sweep()
+{
+	for (std::size_t i = m_components.size(); i-- > 0;)
+	{
+		if (m_components[i]) continue;
+		m_components.erase(m_components.begin() + i);
+		m_comIDs.erase(m_comIDs.begin() + i);
+	}
+	m_retired.clear();
+}
+
+inline void FDS_Entity::destroy() noexcept
+{
+	if (!m_isActive) return;
+	m_isActive = false;
+	if (m_manager) m_manager->m_pendingDestroy.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline FDS_EntityID FDS_CommandBuffer::createEntity()
+{
+	return m_manager->reserveEntity();
+}
+
+inline void FDS_CommandBuffer::destroyEntity(FDS_EntityID id)
+{
+	record(id, [](FDS_EntityManager& manager, FDS_EntityID entity, void*) { manager.destroyEntity(entity); });
+}
+
+template<typename T, typename... TArgs>
+void FDS_CommandBuffer::addComponent(FDS_EntityID id, TArgs&&... mArgs)
+{
+	T* com = m_payloads.create<T>(std::forward<TArgs>(mArgs)...);
+	record(id,
+		[](FDS_EntityManager& manager, FDS_EntityID entity, void* payload)
+		{
+			T* com = static_cast<T*>(payload);
+			bool apply = manager.isAlive(entity);
+			// A parent destroyed earlier in the replay drops the link instead of throwing away the other commands
+			if constexpr (std::is_same_v<T, FDS_Parent>) apply = apply && manager.isAlive(com->entity);
+			if (apply) manager.addComponent<T>(entity, std::move(*com));
+			com->~T();
+		},
+		[](void* payload) { static_cast<T*>(payload)->~T(); },
+		com);
+}
+
+template<typename T>
+void FDS_CommandBuffer::removeComponent(FDS_EntityID id)
+{
+	record(id, [](FDS_EntityManager& manager, FDS_EntityID entity, void*) { manager.removeComponent<T>(entity); });
+}
+
+/*
+	The last frames of a world for rollback, kept with saveFrame() and brought
+	back with restore(). A frame is a full snapshot when entities or component
+	sets changed since the previous save, and at least every `frames` saves;
+	otherwise it holds only the components written since the previous save,
+	found through the change ticks. Restoring a frame that no structural
+	change happened after rewrites only the components written since, which
+	are stamped as changed; otherwise the world is reloaded from the frame's
+	snapshot. Components are copied with the snapshot serializers and
+	FDS_Entity objects are not kept, so such a reload throws while any are
+	alive, see FDS_EntityManager::loadSnapshot().
+*/
+class FDS_RollbackBuffer
+{
+public:
+	explicit FDS_RollbackBuffer(FDS_EntityManager& manager, std::size_t frames = 8)
+		: m_manager(&manager), m_capacity(std::max<std::size_t>(frames, 1))
+	{
+	}
+
+	// Frames restore() can go back to
+	std::size_t size() const noexcept
+	{
+		return std::min(m_frames.size(), m_capacity);
+	}
+
+	void clear() noexcept
+	{
+		m_frames.clear();
+	}
+
+	void saveFrame()
+	{
+		FDS_EntityManager& world = *m_manager;
+		world.flushReserved();
+
+		Frame frame;
+		frame.tick = world.m_tick;
+		frame.structure = world.m_structure;
+		frame.key = m_frames.empty() || m_frames.back().structure != world.m_structure || m_sinceKey >= m_capacity;
+		if (frame.key)
+		{
+			world.saveSnapshot(frame.data);
+			m_sinceKey = 0;
+		}
+		else
+		{
+			world.eachWrittenSince(m_since, [&](const FDS_ComTypeInfo& info, FDS_EntityID id, void* com)
+				{
+					if (!info.save) throw std::runtime_error("FDS_RollbackBuffer: " + std::string(info.name) + " needs an FDS_ComSerializer specialization");
+					frame.entries.push_back({ makeKey(info.id, id), frame.data.size() });
+					info.save(com, 1, frame.data);
+				});
+			std::sort(frame.entries.begin(), frame.entries.end(), [](const Entry& a, const Entry& b) { return a.key < b.key; });
+		}
+		++m_sinceKey;
+		m_since = frame.tick;
+		m_frames.push_back(std::move(frame));
+
+		// Only the keyframe the oldest restorable frame builds on has to stay
+		std::size_t first = m_frames.size() - size();
+		while (!m_frames[first].key) --first;
+		m_frames.erase(m_frames.begin(), m_frames.begin() + first);
+	}
+
+	// Returns the world to the frame saved framesBack saves ago and forgets the frames after it
+	void restore(std::size_t framesBack = 0)
+	{
+		if (framesBack >= size()) throw std::out_of_range("FDS_RollbackBuffer::restore: the frame is not kept");
+
+		FDS_EntityManager& world = *m_manager;
+		world.flushReserved();
+
+		const std::size_t target = m_frames.size() - 1 - framesBack;
+		std::size_t key = target;
+		while (!m_frames[key].key) --key;
+
+		if (m_frames[target].structure == world.m_structure)
+		{
+			world.eachWrittenSince(m_frames[target].tick, [&](const FDS_ComTypeInfo& info, FDS_EntityID id, void* com)
+				{
+					restoreComponent(key, target, info, id, com);
+					world.touchComponent(info.id, id);
+				});
+		}
+		else
+		{
+			const std::uint32_t now = world.m_tick;
+			FDS_SnapshotReader in(m_frames[key].data.data(), m_frames[key].data.size());
+			world.loadSnapshot(in);
+			world.m_tick = now;
+			for (std::size_t f = key + 1; f <= target; ++f) applyDelta(m_frames[f]);
+			for (std::size_t f = key; f <= target; ++f) m_frames[f].structure = world.m_structure;
+		}
+
+		m_frames.erase(m_frames.begin() + target + 1, m_frames.end());
+		m_since = world.m_tick;
+		m_sinceKey = m_frames.size() - key;
+	}
+
+private:
+	struct Entry
+	{
+		std::uint64_t key;
+		std::size_t offset;
+	};
+
+	struct Frame
+	{
+		bool key = false;
+		std::uint32_t tick = 0;
+		std::uint64_t structure = 0;
+		FDS_SnapshotWriter data;                      // snapshot of a keyframe, values of a delta
+		std::vector<Entry> entries;                   // sorted by key
+		std::unique_ptr<FDS_EntityManager> world;     // keyframe loaded on demand for single lookups
+	};
+
+	static std::uint64_t makeKey(FDS_ComID comID, FDS_EntityID id) noexcept
+	{
+		return static_cast<std::uint64_t>(comID) << 32 | id.index;
+	}
+
+	// Writes every value of a delta into the world, which has the structure it was saved with
+	void applyDelta(const Frame& frame)
+	{
+		FDS_EntityManager& world = *m_manager;
+		for (const Entry& entry : frame.entries)
+		{
+			const FDS_ComID comID = static_cast<FDS_ComID>(entry.key >> 32);
+			const std::uint32_t index = static_cast<std::uint32_t>(entry.key);
+			const FDS_EntityID id{ index, world.m_records[index].generation };
+			void* com = world.findComponent(comID, id);
+			if (!com) continue;
+
+			FDS_SnapshotReader in(frame.data.data() + entry.offset, frame.data.size() - entry.offset);
+			FDS_ComRegistry::instance().find(comID)->load(com, 1, in);
+			world.touchComponent(comID, id);
+		}
+	}
+
+	// Loads the value com had in frame target from the newest delta holding it, else from the keyframe
+	void restoreComponent(std::size_t key, std::size_t target, const FDS_ComTypeInfo& info, FDS_EntityID id, void* com)
+	{
+		if (!info.load) throw std::runtime_error("FDS_RollbackBuffer: " + std::string(info.name) + " needs an FDS_ComSerializer specialization");
+
+		const std::uint64_t k = makeKey(info.id, id);
+		for (std::size_t f = target; f > key; --f)
+		{
+			const Frame& frame = m_frames[f];
+			auto it = std::lower_bound(frame.entries.begin(), frame.entries.end(), k, [](const Entry& e, std::uint64_t value) { return e.key < value; });
+			if (it == frame.entries.end() || it->key != k) continue;
+
+			FDS_SnapshotReader in(frame.data.data() + it->offset, frame.data.size() - it->offset);
+			info.load(com, 1, in);
+			return;
+		}
+
+		Frame& keyframe = m_frames[key];
+		if (!keyframe.world)
+		{
+			auto world = std::make_unique<FDS_EntityManager>();
+			FDS_SnapshotReader in(keyframe.data.data(), keyframe.data.size());
+			world->loadSnapshot(in);
+			keyframe.world = std::move(world);
+		}
+		const void* saved = keyframe.world->findComponent(info.id, id);
+		if (!saved) return;
+
+		m_scratch.clear();
+		info.save(saved, 1, m_scratch);
+		FDS_SnapshotReader in(m_scratch.data(), m_scratch.size());
+		info.load(com, 1, in);
+	}
+
+private:
+	FDS_EntityManager* m_manager;
+	std::size_t m_capacity;
+	std::vector<Frame> m_frames;
+	std::uint32_t m_since = 0;
+	std::size_t m_sinceKey = 0;
+	FDS_SnapshotWriter m_scratch;
+};
+
+/*
+	Uniform grid over the x and y of the entities' Pos components, for
+	radius and box queries without testing every pair. update() re-buckets
+	only the entities whose Pos was added or written since the previous
+	update, found through the change ticks; destroyed entities and removed
+	Pos components leave through the manager's destroy signal. Queries see
+	positions as of the last update(). After loading a snapshot or
+	restoring a rollback frame call rebuild(). The grid must not outlive
+	its manager.
+*/
+template<typename Pos>
+class FDS_SpatialGrid
+{
+public:
+	FDS_SpatialGrid(FDS_EntityManager& manager, float cellSize)
+		: m_manager(&manager), m_cellSize(cellSize), m_inverseCell(1.0f / cellSize)
+	{
+		if (!(cellSize > 0.0f)) throw std::invalid_argument("FDS_SpatialGrid: cell size must be positive");
+		m_removed = FDS_ComSignals::Batch::ScopedConnection(manager.onDestroy<Pos>().connect([this](const std::vector<FDS_EntityID>& ids)
+			{
+				for (FDS_EntityID id : ids) remove(id);
+			}));
+	}
+
+	FDS_SpatialGrid(const FDS_SpatialGrid&) = delete;
+	FDS_SpatialGrid& operator=(const FDS_SpatialGrid&) = delete;
+
+	std::size_t size() const noexcept { return m_count; }
+	float getCellSize() const noexcept { return m_cellSize; }
+
+	void update()
+	{
+		m_manager->flushEvents();
+		const std::uint32_t since = m_since;
+		m_since = m_manager->getTick();
+		m_manager->each<const Pos>(FDS_Changed<Pos>{ since }, [this](FDS_EntityID id, const Pos& pos) { place(id, pos.x, pos.y); });
+	}
+
+	void rebuild()
+	{
+		m_cells.clear();
+		m_entries.clear();
+		m_count = 0;
+		m_since = 0;
+		update();
+	}
+
+	// Appends the entities within radius of (x, y)
+	void queryRadius(float x, float y, float radius, std::vector<FDS_EntityID>& out) const
+	{
+		const float radiusSq = radius * radius;
+		visitCells(x - radius, y - radius, x + radius, y + radius, [&](const Cell& cell)
+			{
+				for (std::uint32_t index : cell)
+				{
+					const Entry& entry = m_entries[index];
+					const float dx = entry.x - x;
+					const float dy = entry.y - y;
+					if (dx * dx + dy * dy <= radiusSq && m_manager->isAlive(entry.id)) out.push_back(entry.id);
+				}
+			});
+	}
+
+	std::vector<FDS_EntityID> queryRadius(float x, float y, float radius) const
+	{
+		std::vector<FDS_EntityID> out;
+		queryRadius(x, y, radius, out);
+		return out;
+	}
+
+	// Appends the entities inside the box, bounds included
+	void queryBox(float minX, float minY, float maxX, float maxY, std::vector<FDS_EntityID>& out) const
+	{
+		visitCells(minX, minY, maxX, maxY, [&](const Cell& cell)
+			{
+				for (std::uint32_t index : cell)
+				{
+					const Entry& entry = m_entries[index];
+					if (entry.x >= minX && entry.x <= maxX && entry.y >= minY && entry.y <= maxY && m_manager->isAlive(entry.id)) out.push_back(entry.id);
+				}
+			});
+	}
+
+	std::vector<FDS_EntityID> queryBox(float minX, float minY, float maxX, float maxY) const
+	{
+		std::vector<FDS_EntityID> out;
+		queryBox(minX, minY, maxX, maxY, out);
+		return out;
+	}
+
+private:
+	// Entity indices in the cell
+	using Cell = std::vector<std::uint32_t>;
+
+	struct Entry
+	{
+		FDS_EntityID id = FDS_NULL_ENTITY;
+		std::uint64_t cell = 0;
+		std::uint32_t slot = 0;              // position in the cell
+		float x = 0.0f;
+		float y = 0.0f;
+	};
+
+	// Clamped before the cast, which is undefined outside int32; NaN goes to cell 0 and matches no query
+	std::int32_t coordinate(float value) const noexcept
+	{
+		const float cell = std::floor(value * m_inverseCell);
+		if (std::isnan(cell)) return 0;
+		if (cell <= static_cast<float>(INT32_MIN)) return INT32_MIN;
+		if (cell >= static_cast<float>(INT32_MAX)) return INT32_MAX;
+		return static_cast<std::int32_t>(cell);
+	}
+
+	static std::uint64_t makeCell(std::int32_t cx, std::int32_t cy) noexcept
+	{
+		return static_cast<std::uint64_t>(static_cast<std::uint32_t>(cx)) << 32 | static_cast<std::uint32_t>(cy);
+	}
+
+	void place(FDS_EntityID id, float x, float y)
+	{
+		if (id.index >= m_entries.size()) m_entries.resize(id.index + 1);
+		Entry& entry = m_entries[id.index];
+		const std::uint64_t cell = makeCell(coordinate(x), coordinate(y));
+		entry.x = x;
+		entry.y = y;
+		if (entry.id == id && entry.cell == cell) return;
+
+		if (!entry.id.isNull()) unlink(id.index);
+		Cell& target = m_cells[cell];
+		entry.id = id;
+		entry.cell = cell;
+		entry.slot = static_cast<std::uint32_t>(target.size());
+		target.push_back(id.index);
+		++m_count;
+	}
+
+	void remove(FDS_EntityID id)
+	{
+		if (id.index < m_entries.size() && m_entries[id.index].id == id) unlink(id.index);
+	}
+
+	void unlink(std::uint32_t index)
+	{
+		Entry& entry = m_entries[index];
+		auto it = m_cells.find(entry.cell);
+		Cell& cell = it->second;
+		const std::uint32_t moved = cell.back();
+		cell[entry.slot] = moved;
+		m_entries[moved].slot = entry.slot;
+		cell.pop_back();
+		if (cell.empty()) m_cells.erase(it);
+		entry.id = FDS_NULL_ENTITY;
+		--m_count;
+	}
+
+	// Walks the cells the box overlaps, or every occupied cell when there are fewer of those
+	template<typename Func>
+	void visitCells(float minX, float minY, float maxX, float maxY, Func&& func) const
+	{
+		if (!(minX <= maxX && minY <= maxY) || m_cells.empty()) return;
+
+		const std::int64_t x0 = coordinate(minX), y0 = coordinate(minY);
+		const std::int64_t x1 = coordinate(maxX), y1 = coordinate(maxY);
+		// Compared without forming the product, which wraps for boxes spanning the whole int32 range
+		const std::uint64_t width = static_cast<std::uint64_t>(x1 - x0 + 1);
+		const std::uint64_t height = static_cast<std::uint64_t>(y1 - y0 + 1);
+		if (width > m_cells.size() || height > m_cells.size() / width)
+		{
+			for (const auto& [key, cell] : m_cells)
+			{
+				const std::int64_t cx = static_cast<std::int32_t>(key >> 32);
+				const std::int64_t cy = static_cast<std::int32_t>(key & 0xFFFFFFFFu);
+				if (cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1) func(cell);
+			}
+			return;
+		}
+
+		for (std::int64_t cx = x0; cx <= x1; ++cx)
+		{
+			for (std::int64_t cy = y0; cy <= y1; ++cy)
+			{
+				auto it = m_cells.find(makeCell(static_cast<std::int32_t>(cx), static_cast<std::int32_t>(cy)));
+				if (it != m_cells.end()) func(it->second);
+			}
+		}
+	}
+
 private:
-	std::vector<std::unique_ptr<FDS_Entity>> m_entities;
+	FDS_EntityManager* m_manager;
+	float m_cellSize;
+	float m_inverseCell;
+	std::unordered_map<std::uint64_t, Cell> m_cells;
+	std::vector<Entry> m_entries;                   // by entity index
+	std::size_t m_count = 0;
+	std::uint32_t m_since = 0;
+	FDS_ComSignals::Batch::ScopedConnection m_removed;
 };
\ No newline at end of file
@@ -0,0 +1,222 @@
+/*
+		Copyright(C) 2025 Fordans
+						This source follows the GPL licence
+						See https://www.gnu.org/licenses/gpl-3.0.html for details
+*/
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <cstddef>
+#include <memory>
+
+// Tracks a group of submitted jobs so the caller can wait for all of them
+class FDS_JobCounter
+{
+public:
+	bool done() const noexcept
+	{
+		return m_pending.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+	friend class FDS_JobSystem;
+
+	std::atomic<std::size_t> m_pending{ 0 };
+	std::mutex m_errorMutex;
+	std::exception_ptr m_error;
+};
+
+/*
+	Work-stealing pool of worker threads. Every worker owns a deque: jobs it
+	submits go to the back and it pops from the back, idle workers steal from
+	the front of the others. Jobs from other threads go to a shared queue.
+	The thread waiting on a counter runs jobs too, so a pool with zero workers
+	executes everything on the caller. The first exception thrown by a job is
+	rethrown from wait().
+*/
+class FDS_JobSystem
+{
+public:
+	explicit FDS_JobSystem(std::size_t threadCount = defaultThreadCount())
+	{
+		// The last queue is the shared one
+		for (std::size_t i = 0; i <= threadCount; ++i) m_queues.push_back(std::make_unique<Queue>());
+
+		m_threads.reserve(threadCount);
+		for (std::size_t i = 0; i < threadCount; ++i)
+		{
+			m_threads.emplace_back([this, i]() { workerLoop(i); });
+		}
+	}
+
+	~FDS_JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_stop = true;
+		}
+		m_sleepCv.notify_all();
+		for (auto& t : m_threads) t.join();
+	}
+
+	// Hardware threads minus the one that submits and waits
+	static std::size_t defaultThreadCount() noexcept
+	{
+		const std::size_t hardware = std::thread::hardware_concurrency();
+		return hardware > 1 ? hardware - 1 : 0;
+	}
+
+	std::size_t getThreadCount() const noexcept
+	{
+		return m_threads.size();
+	}
+
+	void submit(FDS_JobCounter& counter, std::function<void()> job)
+	{
+		counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+
+		// Counted before it is visible so m_queued never drops below the real number of jobs
+		m_queued.fetch_add(1, std::memory_order_release);
+		Queue& queue = *m_queues[isWorker() ? localWorker().index : m_threads.size()];
+		{
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			queue.jobs.push_back({ std::move(job), &counter });
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_sleepCv.notify_one();
+	}
+
+	// Runs jobs on the calling thread until every job of the counter has finished
+	void wait(FDS_JobCounter& counter)
+	{
+		const std::size_t home = isWorker() ? localWorker().index : m_threads.size();
+		while (!counter.done())
+		{
+			if (!runOne(home)) std::this_thread::yield();
+		}
+
+		if (counter.m_error)
+		{
+			std::exception_ptr error = counter.m_error;
+			counter.m_error = nullptr;
+			std::rethrow_exception(error);
+		}
+	}
+
+	FDS_JobSystem(const FDS_JobSystem&) = delete;
+	FDS_JobSystem& operator=(const FDS_JobSystem&) = delete;
+	FDS_JobSystem(FDS_JobSystem&&) = delete;
+	FDS_JobSystem& operator=(FDS_JobSystem&&) = delete;
+
+private:
+	struct Job
+	{
+		std::function<void()> func;
+		FDS_JobCounter* counter;
+	};
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	struct Worker
+	{
+		const FDS_JobSystem* system = nullptr;
+		std::size_t index = 0;
+	};
+
+	static Worker& localWorker() noexcept
+	{
+		thread_local Worker worker;
+		return worker;
+	}
+
+	bool isWorker() const noexcept
+	{
+		return localWorker().system == this;
+	}
+
+	// Own queue newest first, then the oldest job of the shared queue and the other workers
+	bool pop(std::size_t home, Job& job)
+	{
+		if (m_queued.load(std::memory_order_acquire) == 0) return false;
+
+		const std::size_t count = m_queues.size();
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			Queue& queue = *m_queues[(home + i) % count];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.jobs.empty()) continue;
+
+			if (i == 0)
+			{
+				job = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+			}
+			else
+			{
+				job = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+			}
+			m_queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+		return false;
+	}
+
+	bool runOne(std::size_t home)
+	{
+		Job job;
+		if (!pop(home, job)) return false;
+		execute(job);
+		return true;
+	}
+
+	static void execute(Job& job)
+	{
+		try
+		{
+			job.func();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(job.counter->m_errorMutex);
+			if (!job.counter->m_error) job.counter->m_error = std::current_exception();
+		}
+		job.counter->m_pending.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	void workerLoop(std::size_t index)
+	{
+		localWorker() = { this, index };
+		for (;;)
+		{
+			if (runOne(index)) continue;
+
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			m_sleepCv.wait(lock, [this]() { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+			if (m_stop && m_queued.load(std::memory_order_acquire) == 0) return;
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_threads;
+	std::atomic<std::size_t> m_queued{ 0 };
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCv;
+	bool m_stop = false;
+};
\ No newline at end of file
@@ -0,0 +1,420 @@
+/*
+		Copyright(C) 2025 Fordans
+						This source follows the GPL licence
+						See https://www.gnu.org/licenses/gpl-3.0.html for details
+*/
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+
+#include "FDS_SignalSlotSystem.h"
+
+// Nanoseconds of a steady clock, the profiler's time base
+inline std::int64_t FDS_ProfileNow() noexcept
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*
+	Heap allocations of the calling thread. The library cannot see the
+	application's allocator, so nothing is counted until the application
+	calls FDS_CountAllocation(), e.g. from a replaced global operator new.
+*/
+inline std::uint64_t& FDS_AllocationCount() noexcept
+{
+	thread_local std::uint64_t count = 0;
+	return count;
+}
+
+inline void FDS_CountAllocation() noexcept
+{
+	++FDS_AllocationCount();
+}
+
+// One timed scope of a frame
+struct FDS_ProfileSample
+{
+	std::uint32_t scope;          // index of the scope's name, see FDS_Profiler::getScopeName()
+	std::uint32_t thread;         // small number of the recording thread
+	std::int64_t start;           // nanoseconds since the profiler was created
+	std::int64_t duration;        // nanoseconds
+	std::uint64_t entities;
+	std::uint64_t allocations;
+};
+
+struct FDS_ProfileFrame
+{
+	std::uint64_t index = 0;
+	std::uint32_t thread = 0;
+	std::int64_t start = 0;
+	std::int64_t duration = 0;
+	std::vector<FDS_ProfileSample> samples;
+};
+
+// Distribution of a scope's total per frame over the profiler's window, times in seconds
+struct FDS_ProfileStats
+{
+	std::size_t frames = 0;       // frames of the window in which the scope ran
+	double mean = 0.0;
+	double p50 = 0.0;
+	double p90 = 0.0;
+	double p99 = 0.0;
+	double max = 0.0;
+	double entities = 0.0;        // mean per frame
+	double allocations = 0.0;     // mean per frame
+};
+
+/*
+	Keeps the samples of the last window frames. Scopes are timed from any
+	thread with FDS_Profiler::Scope; samples count between beginFrame() and
+	endFrame() and are dropped outside. Stats are percentiles of a scope's
+	total per frame, and saveTrace() writes the window in the Chrome trace
+	event format, which chrome://tracing and Perfetto open.
+*/
+class FDS_Profiler
+{
+public:
+	static constexpr std::size_t DEFAULT_WINDOW = 240;
+
+	/*
+		Times its lifetime as one sample. A nullptr profiler makes it a no-op,
+		so instrumented code needs no branch of its own. Scopes nest per thread;
+		addEntities() counts towards the innermost one.
+	*/
+	class Scope
+	{
+	public:
+		Scope(FDS_Profiler* profiler, std::string_view name)
+			: Scope(profiler, profiler ? profiler->scope(name) : 0)
+		{
+		}
+
+		Scope(FDS_Profiler* profiler, std::uint32_t scope) noexcept : m_profiler(profiler), m_scope(scope)
+		{
+			if (!m_profiler) return;
+			m_parent = current();
+			current() = this;
+			m_allocations = FDS_AllocationCount();
+			m_start = FDS_ProfileNow();
+		}
+
+		~Scope()
+		{
+			if (!m_profiler) return;
+			const std::int64_t end = FDS_ProfileNow();
+			current() = m_parent;
+			try
+			{
+				m_profiler->record(m_scope, m_start, end - m_start, m_entities, FDS_AllocationCount() - m_allocations);
+			}
+			catch (...)
+			{
+				// A sample that cannot be stored is lost, the frame goes on
+			}
+		}
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		friend class FDS_Profiler;
+
+		static Scope*& current() noexcept
+		{
+			thread_local Scope* scope = nullptr;
+			return scope;
+		}
+
+	private:
+		FDS_Profiler* m_profiler;
+		std::uint32_t m_scope;
+		Scope* m_parent = nullptr;
+		std::int64_t m_start = 0;
+		std::uint64_t m_entities = 0;
+		std::uint64_t m_allocations = 0;
+	};
+
+	explicit FDS_Profiler(std::size_t window = DEFAULT_WINDOW) : m_frames(std::max<std::size_t>(window, 1)), m_origin(FDS_ProfileNow())
+	{
+	}
+
+	FDS_Profiler(const FDS_Profiler&) = delete;
+	FDS_Profiler& operator=(const FDS_Profiler&) = delete;
+
+	// Emitted by endFrame() for every frame longer than the budget
+	fds::Signal<const FDS_ProfileFrame&> overBudget;
+
+	// Index of the scope called name, registered on first use
+	std::uint32_t scope(std::string_view name)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_scopeIndex.find(name);
+		if (it != m_scopeIndex.end()) return it->second;
+
+		const std::uint32_t index = static_cast<std::uint32_t>(m_names.size());
+		m_names.emplace_back(name);
+		m_scopeIndex.emplace(m_names.back(), index);
+		return index;
+	}
+
+	std::string getScopeName(std::uint32_t scope) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return scope < m_names.size() ? m_names[scope] : std::string();
+	}
+
+	std::size_t getScopeCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_names.size();
+	}
+
+	// Adds count to the entities of the calling thread's innermost scope, if any
+	static void addEntities(std::uint64_t count) noexcept
+	{
+		if (Scope* scope = Scope::current()) scope->m_entities += count;
+	}
+
+	// Adds a sample measured by the caller, e.g. a total summed over many calls
+	void record(std::uint32_t scope, std::int64_t start, std::int64_t duration, std::uint64_t entities = 0, std::uint64_t allocations = 0)
+	{
+		const std::uint32_t thread = threadNumber();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_inFrame) return;
+		m_current.samples.push_back({ scope, thread, start - m_origin, duration, entities, allocations });
+	}
+
+	void beginFrame()
+	{
+		const std::uint32_t thread = threadNumber();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_current.samples.clear();
+		m_current.index = m_frameCount;
+		m_current.thread = thread;
+		m_current.start = FDS_ProfileNow() - m_origin;
+		m_inFrame = true;
+	}
+
+	void endFrame()
+	{
+		const FDS_ProfileFrame* late = nullptr;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_inFrame) return;
+			m_inFrame = false;
+			m_current.duration = FDS_ProfileNow() - m_origin - m_current.start;
+
+			// The evicted frame's samples become the next frame's buffer
+			FDS_ProfileFrame& slot = m_frames[m_frameCount % m_frames.size()];
+			std::swap(slot, m_current);
+			++m_frameCount;
+			if (m_budget > 0 && slot.duration > m_budget)
+			{
+				++m_overBudgetCount;
+				late = &slot;
+			}
+		}
+		if (late) overBudget.emit(*late);
+	}
+
+	// Frames longer than seconds are counted and reported through overBudget, 0 turns it off
+	void setBudget(double seconds) noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_budget = static_cast<std::int64_t>(seconds * 1e9);
+	}
+
+	double getBudget() const noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return static_cast<double>(m_budget) * 1e-9;
+	}
+
+	std::uint64_t getOverBudgetCount() const noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_overBudgetCount;
+	}
+
+	std::uint64_t getFrameCount() const noexcept
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_frameCount;
+	}
+
+	std::size_t getWindow() const noexcept
+	{
+		return m_frames.size();
+	}
+
+	// Stats of the scope called name, empty if it never ran in the window
+	FDS_ProfileStats getStats(std::string_view name) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_scopeIndex.find(name);
+		if (it == m_scopeIndex.end()) return {};
+
+		const std::uint32_t scope = it->second;
+		return summarize([scope](const FDS_ProfileFrame& frame, Total& total)
+			{
+				for (const FDS_ProfileSample& sample : frame.samples)
+				{
+					if (sample.scope != scope) continue;
+					total.duration += sample.duration;
+					total.entities += sample.entities;
+					total.allocations += sample.allocations;
+					total.ran = true;
+				}
+			});
+	}
+
+	// Stats of whole frames, from beginFrame() to endFrame()
+	FDS_ProfileStats getFrameStats() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return summarize([](const FDS_ProfileFrame& frame, Total& total)
+			{
+				total.duration = frame.duration;
+				total.ran = true;
+			});
+	}
+
+	// Writes the frames of the window, oldest first, as Chrome trace events
+	void saveTrace(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::trunc);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+			const char* separator = "\n";
+			const auto event = [&](const std::string& name, std::uint32_t thread, std::int64_t start, std::int64_t duration, std::uint64_t entities, std::uint64_t allocations)
+			{
+				char numbers[192];
+				std::snprintf(numbers, sizeof(numbers), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"entities\":%llu,\"allocations\":%llu}}",
+					thread, static_cast<double>(start) * 1e-3, static_cast<double>(duration) * 1e-3,
+					static_cast<unsigned long long>(entities), static_cast<unsigned long long>(allocations));
+				file << separator << "{\"name\":\"" << escape(name) << numbers;
+				separator = ",\n";
+			};
+
+			const std::size_t stored = static_cast<std::size_t>(std::min<std::uint64_t>(m_frameCount, m_frames.size()));
+			for (std::size_t i = 0; i < stored; ++i)
+			{
+				const FDS_ProfileFrame& frame = m_frames[(m_frameCount - stored + i) % m_frames.size()];
+				event("Frame " + std::to_string(frame.index), frame.thread, frame.start, frame.duration, 0, 0);
+				for (const FDS_ProfileSample& sample : frame.samples)
+				{
+					event(m_names[sample.scope], sample.thread, sample.start, sample.duration, sample.entities, sample.allocations);
+				}
+			}
+			file << "\n]}\n";
+		}
+		if (!file) throw std::runtime_error("FDS_Profiler: cannot write " + path);
+	}
+
+	// Forgets every recorded frame, scope names stay
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (FDS_ProfileFrame& frame : m_frames) frame = {};
+		m_current.samples.clear();
+		m_inFrame = false;
+		m_frameCount = 0;
+		m_overBudgetCount = 0;
+	}
+
+private:
+	struct Total
+	{
+		std::int64_t duration = 0;
+		std::uint64_t entities = 0;
+		std::uint64_t allocations = 0;
+		bool ran = false;
+	};
+
+	// Small number per thread, in the order threads first record anything
+	static std::uint32_t threadNumber() noexcept
+	{
+		static std::atomic<std::uint32_t> next{ 0 };
+		thread_local const std::uint32_t number = next.fetch_add(1, std::memory_order_relaxed);
+		return number;
+	}
+
+	// Nearest-rank percentiles of each stored frame's total, the caller holds the mutex
+	template<typename Measure>
+	FDS_ProfileStats summarize(Measure&& measure) const
+	{
+		FDS_ProfileStats stats;
+		std::vector<std::int64_t> durations;
+		const std::size_t stored = static_cast<std::size_t>(std::min<std::uint64_t>(m_frameCount, m_frames.size()));
+		for (std::size_t i = 0; i < stored; ++i)
+		{
+			Total total;
+			measure(m_frames[i], total);
+			if (!total.ran) continue;
+			durations.push_back(total.duration);
+			stats.entities += static_cast<double>(total.entities);
+			stats.allocations += static_cast<double>(total.allocations);
+		}
+		if (durations.empty()) return stats;
+
+		std::sort(durations.begin(), durations.end());
+		const double count = static_cast<double>(durations.size());
+		const auto percentile = [&](double p)
+		{
+			const std::size_t rank = static_cast<std::size_t>(std::ceil(p * count));
+			return static_cast<double>(durations[std::min(durations.size(), std::max<std::size_t>(rank, 1)) - 1]) * 1e-9;
+		};
+
+		double sum = 0.0;
+		for (std::int64_t duration : durations) sum += static_cast<double>(duration);
+		stats.frames = durations.size();
+		stats.mean = sum / count * 1e-9;
+		stats.p50 = percentile(0.50);
+		stats.p90 = percentile(0.90);
+		stats.p99 = percentile(0.99);
+		stats.max = static_cast<double>(durations.back()) * 1e-9;
+		stats.entities /= count;
+		stats.allocations /= count;
+		return stats;
+	}
+
+	static std::string escape(const std::string& text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\') escaped += '\\';
+			escaped += c;
+		}
+		return escaped;
+	}
+
+private:
+	mutable std::mutex m_mutex;
+	std::deque<std::string> m_names;
+	std::unordered_map<std::string_view, std::uint32_t> m_scopeIndex;   // views into m_names
+	std::vector<FDS_ProfileFrame> m_frames;
+	FDS_ProfileFrame m_current;
+	bool m_inFrame = false;
+	std::uint64_t m_frameCount = 0;
+	std::int64_t m_budget = 0;
+	std::uint64_t m_overBudgetCount = 0;
+	const std::int64_t m_origin;
+};
\ No newline at end of file
@@ -146,6 +146,11 @@ namespace fds
             slots_.clear();
         }
 
+        bool empty() const
+        {
+            return slots_.empty();
+        }
+
     private:
         struct SlotData
         {
@@ -0,0 +1,115 @@
+/*
+		Copyright(C) 2025 Fordans
+						This source follows the GPL licence
+						See https://www.gnu.org/licenses/gpl-3.0.html for details
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX__)
+#include <immintrin.h>
+#define FDS_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FDS_SIMD_SSE
+#endif
+
+/*
+	Float stream kernels, eight lanes per instruction with AVX, four with SSE
+	and a scalar loop otherwise or for the tail. Arrays may be unaligned and
+	must not overlap unless they are the same array.
+*/
+
+/*
+	Specialize for plain structs of floats such as { float x, y, z; }, which
+	an array of then holds as one float stream:
+		template<> struct FDS_FloatLanes<Position> { static constexpr bool value = true; };
+	Member types cannot be inspected, so a struct mixing in ints must never
+	opt in; the layout is still checked by FDS_IS_FLOAT_LANES.
+*/
+template<typename T>
+struct FDS_FloatLanes
+{
+	static constexpr bool value = false;
+};
+
+template<typename T>
+constexpr bool FDS_IS_FLOAT_LANES = FDS_FloatLanes<std::remove_const_t<T>>::value
+	&& std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T>
+	&& alignof(T) == alignof(float) && sizeof(T) % sizeof(float) == 0;
+
+// y[i] += a * x[i]
+inline void FDS_SimdAxpy(float* y, const float* x, float a, std::size_t count) noexcept
+{
+	std::size_t i = 0;
+#if defined(FDS_SIMD_AVX)
+	const __m256 a8 = _mm256_set1_ps(a);
+	for (; i + 8 <= count; i += 8)
+	{
+#if defined(__FMA__)
+		const __m256 r = _mm256_fmadd_ps(a8, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i));
+#else
+		const __m256 r = _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(a8, _mm256_loadu_ps(x + i)));
+#endif
+		_mm256_storeu_ps(y + i, r);
+	}
+#elif defined(FDS_SIMD_SSE)
+	const __m128 a4 = _mm_set1_ps(a);
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(a4, _mm_loadu_ps(x + i))));
+	}
+#endif
+	for (; i < count; ++i) y[i] += a * x[i];
+}
+
+// y[i] += x[i]
+inline void FDS_SimdAdd(float* y, const float* x, std::size_t count) noexcept
+{
+	std::size_t i = 0;
+#if defined(FDS_SIMD_AVX)
+	for (; i + 8 <= count; i += 8) _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i)));
+#elif defined(FDS_SIMD_SSE)
+	for (; i + 4 <= count; i += 4) _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_loadu_ps(x + i)));
+#endif
+	for (; i < count; ++i) y[i] += x[i];
+}
+
+// y[i] *= a
+inline void FDS_SimdScale(float* y, float a, std::size_t count) noexcept
+{
+	std::size_t i = 0;
+#if defined(FDS_SIMD_AVX)
+	const __m256 a8 = _mm256_set1_ps(a);
+	for (; i + 8 <= count; i += 8) _mm256_storeu_ps(y + i, _mm256_mul_ps(_mm256_loadu_ps(y + i), a8));
+#elif defined(FDS_SIMD_SSE)
+	const __m128 a4 = _mm_set1_ps(a);
+	for (; i + 4 <= count; i += 4) _mm_storeu_ps(y + i, _mm_mul_ps(_mm_loadu_ps(y + i), a4));
+#endif
+	for (; i < count; ++i) y[i] *= a;
+}
+
+// y[i] = y[i] * damping + a * x[i], e.g. damped velocity from acceleration
+inline void FDS_SimdDampedAxpy(float* y, const float* x, float a, float damping, std::size_t count) noexcept
+{
+	std::size_t i = 0;
+#if defined(FDS_SIMD_AVX)
+	const __m256 a8 = _mm256_set1_ps(a);
+	const __m256 d8 = _mm256_set1_ps(damping);
+	for (; i + 8 <= count; i += 8)
+	{
+		_mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(y + i), d8), _mm256_mul_ps(a8, _mm256_loadu_ps(x + i))));
+	}
+#elif defined(FDS_SIMD_SSE)
+	const __m128 a4 = _mm_set1_ps(a);
+	const __m128 d4 = _mm_set1_ps(damping);
+	for (; i + 4 <= count; i += 4)
+	{
+		_mm_storeu_ps(y + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(y + i), d4), _mm_mul_ps(a4, _mm_loadu_ps(x + i))));
+	}
+#endif
+	for (; i < count; ++i) y[i] = y[i] * damping + a * x[i];
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*
+		Copyright(C) 2025 Fordans
+						This source follows the GPL licence
+						See https://www.gnu.org/licenses/gpl-3.0.html for details
+*/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <fstream>
+
+#if defined(_WIN32)
+#include "../FDS_Win32/FDS_CleanWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Growing byte buffer a snapshot is written to, in the byte order of the machine
+class FDS_SnapshotWriter
+{
+public:
+	void write(const void* data, std::size_t size)
+	{
+		if (!size) return;
+		const std::size_t offset = m_buffer.size();
+		m_buffer.resize(offset + size);
+		std::memcpy(m_buffer.data() + offset, data, size);
+	}
+
+	template<typename T>
+	void write(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values are written as bytes");
+		write(&value, sizeof(T));
+	}
+
+	void reserve(std::size_t size)
+	{
+		m_buffer.reserve(size);
+	}
+
+	void clear() noexcept
+	{
+		m_buffer.clear();
+	}
+
+	const std::byte* data() const noexcept { return m_buffer.data(); }
+	std::size_t size() const noexcept { return m_buffer.size(); }
+
+	void saveFile(const std::string& path) const
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(m_buffer.data()), static_cast<std::streamsize>(m_buffer.size()));
+		if (!file) throw std::runtime_error("FDS_SnapshotWriter: cannot write " + path);
+	}
+
+private:
+	std::vector<std::byte> m_buffer;
+};
+
+// Reads a snapshot in place, the memory must outlive the reader
+class FDS_SnapshotReader
+{
+public:
+	FDS_SnapshotReader(const void* data, std::size_t size) noexcept
+		: m_data(static_cast<const std::byte*>(data)), m_size(size)
+	{
+	}
+
+	// Pointer to the next size bytes, which are skipped; throws past the end
+	const std::byte* take(std::size_t size)
+	{
+		if (size > m_size - m_offset) throw std::runtime_error("FDS_SnapshotReader: snapshot is truncated");
+		const std::byte* data = m_data + m_offset;
+		m_offset += size;
+		return data;
+	}
+
+	void read(void* data, std::size_t size)
+	{
+		if (size) std::memcpy(data, take(size), size);
+	}
+
+	template<typename T>
+	T read()
+	{
+		static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values are read as bytes");
+		T value;
+		read(&value, sizeof(T));
+		return value;
+	}
+
+	std::size_t remaining() const noexcept { return m_size - m_offset; }
+
+private:
+	const std::byte* m_data;
+	std::size_t m_size;
+	std::size_t m_offset = 0;
+};
+
+// Read-only view of a whole file mapped into memory
+class FDS_MappedFile
+{
+public:
+	explicit FDS_MappedFile(const std::string& path)
+	{
+#if defined(_WIN32)
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE) throw std::runtime_error("FDS_MappedFile: cannot open " + path);
+
+		LARGE_INTEGER size;
+		GetFileSizeEx(m_file, &size);
+		m_size = static_cast<std::size_t>(size.QuadPart);
+		if (m_size)
+		{
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping) m_data = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+			if (!m_data)
+			{
+				close();
+				throw std::runtime_error("FDS_MappedFile: cannot map " + path);
+			}
+		}
+#else
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) throw std::runtime_error("FDS_MappedFile: cannot open " + path);
+
+		struct stat info;
+		if (::fstat(fd, &info) == 0) m_size = static_cast<std::size_t>(info.st_size);
+		if (m_size)
+		{
+			void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED) m_data = data;
+		}
+		::close(fd);
+		if (m_size && !m_data) throw std::runtime_error("FDS_MappedFile: cannot map " + path);
+#endif
+	}
+
+	~FDS_MappedFile()
+	{
+		close();
+	}
+
+	FDS_MappedFile(const FDS_MappedFile&) = delete;
+	FDS_MappedFile& operator=(const FDS_MappedFile&) = delete;
+
+	const void* data() const noexcept { return m_data; }
+	std::size_t size() const noexcept { return m_size; }
+
+private:
+	void close() noexcept
+	{
+#if defined(_WIN32)
+		if (m_data) UnmapViewOfFile(m_data);
+		if (m_mapping) CloseHandle(m_mapping);
+		if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+		m_mapping = nullptr;
+		m_file = INVALID_HANDLE_VALUE;
+#else
+		if (m_data) ::munmap(const_cast<void*>(m_data), m_size);
+#endif
+		m_data = nullptr;
+	}
+
+private:
+	const void* m_data = nullptr;
+	std::size_t m_size = 0;
+#if defined(_WIN32)
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+#endif
+};
\ No newline at end of file